@@ -0,0 +1,112 @@
+#pragma once
+
+// Non-allocating, trivially copyable replacement for std::function actions.
+//
+// Define STATEMACHINE_LIGHTWEIGHT_ACTIONS to make actionFunction (and
+// iActionFunction) an actionDelegate. The stateTransition table then becomes
+// trivially copyable: copying a machine or filling a transitionErrorContext is
+// a plain memcpy, and no action can ever allocate.
+//
+// An actionDelegate holds one of:
+//   - nullptr (no action)
+//   - a plain function        void f(uint8_t toPage, uint8_t event, void* context)
+//   - a function plus a user pointer
+//                             void f(uint8_t toPage, uint8_t event, void* context, void* user)
+//   - any trivially copyable callable (e.g. a lambda capturing pointers or
+//     small values) no larger than STATEMACHINE_ACTION_STORAGE bytes
+// Callables that own resources (std::string captures, std::function) do not
+// compile; capture a pointer to them instead.
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <type_traits>
+
+// Inline storage for captured state, in bytes
+#ifndef STATEMACHINE_ACTION_STORAGE
+    #define STATEMACHINE_ACTION_STORAGE (2 * sizeof(void*))
+#endif
+
+class actionDelegate {
+public:
+    using plainFunction = void (*)(uint8_t, uint8_t, void*);
+    using userFunction = void (*)(uint8_t, uint8_t, void*, void*);
+
+    actionDelegate() : _invoke(nullptr) { memset(_storage, 0, sizeof(_storage)); }
+    actionDelegate(std::nullptr_t) : actionDelegate() {}
+
+    actionDelegate(plainFunction function) : actionDelegate() {
+        if (function) {
+            store(function);
+            _invoke = &invokePlain;
+        }
+    }
+
+    actionDelegate(userFunction function, void* user) : actionDelegate() {
+        if (function) {
+            userBinding binding = { function, user };
+            store(binding);
+            _invoke = &invokeUser;
+        }
+    }
+
+    template <typename F,
+              typename = typename std::enable_if<
+                  !std::is_convertible<F, plainFunction>::value &&
+                  !std::is_same<typename std::decay<F>::type, actionDelegate>::value>::type>
+    actionDelegate(const F& callable) : actionDelegate() {
+        static_assert(sizeof(F) <= STATEMACHINE_ACTION_STORAGE,
+                      "actionDelegate: callable exceeds STATEMACHINE_ACTION_STORAGE");
+        static_assert(std::is_trivially_copyable<F>::value,
+                      "actionDelegate: callable must be trivially copyable");
+        static_assert(std::is_trivially_destructible<F>::value,
+                      "actionDelegate: callable must be trivially destructible");
+        static_assert(alignof(F) <= alignof(void*),
+                      "actionDelegate: callable alignment exceeds the inline storage alignment");
+        new (_storage) F(callable);
+        _invoke = &invokeCallable<F>;
+    }
+
+    void operator()(uint8_t toPage, uint8_t event, void* context) const {
+        _invoke(_storage, toPage, event, context);
+    }
+
+    explicit operator bool() const { return _invoke != nullptr; }
+
+private:
+    using invoker = void (*)(const void*, uint8_t, uint8_t, void*);
+
+    struct userBinding {
+        userFunction function;
+        void* user;
+    };
+
+    template <typename T>
+    void store(const T& value) {
+        static_assert(sizeof(T) <= STATEMACHINE_ACTION_STORAGE, "actionDelegate: storage too small");
+        memcpy(_storage, &value, sizeof(T));
+    }
+
+    static void invokePlain(const void* storage, uint8_t toPage, uint8_t event, void* context) {
+        plainFunction function;
+        memcpy(&function, storage, sizeof(function));
+        function(toPage, event, context);
+    }
+
+    static void invokeUser(const void* storage, uint8_t toPage, uint8_t event, void* context) {
+        userBinding binding;
+        memcpy(&binding, storage, sizeof(binding));
+        binding.function(toPage, event, context, binding.user);
+    }
+
+    template <typename F>
+    static void invokeCallable(const void* storage, uint8_t toPage, uint8_t event, void* context) {
+        (*static_cast<const F*>(storage))(toPage, event, context);
+    }
+
+    invoker _invoke;
+    alignas(void*) unsigned char _storage[STATEMACHINE_ACTION_STORAGE];
+};
+
+static_assert(std::is_trivially_copyable<actionDelegate>::value, "actionDelegate must be trivially copyable");
@@ -0,0 +1,257 @@
+#pragma once
+
+// Bounded lock-free queues that carry events into a state machine from other
+// execution contexts (ISRs, RTOS tasks, host threads).
+//
+// spscEventQueue - one producer, one consumer. push() is wait-free and safe
+//                  from interrupt context; pop() runs on the thread that owns
+//                  the state machine.
+// mpscEventQueue - several producers, one consumer. Each producer owns a lane
+//                  (an SPSC ring padded onto its own cache lines) so producers
+//                  never contend; drainInto() takes lanes round-robin.
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#else
+unsigned long micros();
+#endif
+
+// Slots in the queue behind postEvent()/drainEvents(); must be a power of two
+#ifndef STATEMACHINE_EVENT_QUEUE_SIZE
+    #define STATEMACHINE_EVENT_QUEUE_SIZE 16
+#endif
+
+// Slots in the high-priority lane of postEvent(); must be a power of two
+#ifndef STATEMACHINE_PRIORITY_QUEUE_SIZE
+    #define STATEMACHINE_PRIORITY_QUEUE_SIZE 4
+#endif
+
+// Multi-producer queue geometry: lanes (one per producer) and slots per lane (power of two)
+#ifndef STATEMACHINE_MPSC_LANES
+    #define STATEMACHINE_MPSC_LANES 4
+#endif
+
+#ifndef STATEMACHINE_MPSC_LANE_SIZE
+    #define STATEMACHINE_MPSC_LANE_SIZE 16
+#endif
+
+// Producer and consumer counters are kept this many bytes apart
+#ifndef STATEMACHINE_CACHE_LINE_SIZE
+    #define STATEMACHINE_CACHE_LINE_SIZE 64
+#endif
+
+// An event waiting to be processed
+struct queuedEvent {
+    uint8_t event;
+    void* context;
+};
+
+// Same, stamped with micros() when posted so queueing latency can be measured
+struct timedQueuedEvent {
+    uint8_t event;
+    void* context;
+    uint32_t postedAt;
+};
+
+template <size_t Capacity, typename Item = queuedEvent>
+class spscEventQueue {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                  "spscEventQueue capacity must be a power of two");
+
+public:
+    spscEventQueue() : _tail(0), _overflows(0), _head(0) {}
+
+    // Producer side. Returns false and counts an overflow when the queue is full.
+    bool push(const Item& item) {
+        const uint32_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail - _head.load(std::memory_order_acquire) >= Capacity) {
+            _overflows.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        _slots[tail & (Capacity - 1)] = item;
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool push(uint8_t event, void* context) {
+        Item item = Item();
+        item.event = event;
+        item.context = context;
+        return push(item);
+    }
+
+    // Consumer side. Returns false when the queue is empty.
+    bool pop(Item& out) {
+        const uint32_t head = _head.load(std::memory_order_relaxed);
+        if (head == _tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        out = _slots[head & (Capacity - 1)];
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Snapshot only; either side may be moving
+    size_t size() const {
+        return _tail.load(std::memory_order_acquire) - _head.load(std::memory_order_acquire);
+    }
+    bool empty() const { return size() == 0; }
+    static constexpr size_t capacity() { return Capacity; }
+
+    uint32_t getOverflowCount() const { return _overflows.load(std::memory_order_relaxed); }
+    void resetOverflowCount() { _overflows.store(0, std::memory_order_relaxed); }
+
+private:
+    // Free-running counters; unsigned wrap keeps tail - head correct. The producer's
+    // and the consumer's counters sit on separate cache lines, as in mpscEventQueue.
+    std::atomic<uint32_t> _tail;
+    std::atomic<uint32_t> _overflows;
+    char _producerPad[STATEMACHINE_CACHE_LINE_SIZE];
+    std::atomic<uint32_t> _head;
+    char _consumerPad[STATEMACHINE_CACHE_LINE_SIZE];
+    Item _slots[Capacity];
+};
+
+// Multi-producer queue counters; latencies are micros() from push to drain
+struct eventQueueStats {
+    uint32_t enqueued;
+    uint32_t drained;
+    uint32_t overflows;
+    uint32_t depthHighWater;      // Deepest any single lane has been
+    uint32_t maxLatency;
+    uint32_t averageLatency;
+
+    eventQueueStats() : enqueued(0), drained(0), overflows(0), depthHighWater(0),
+                        maxLatency(0), averageLatency(0) {}
+};
+
+template <size_t Lanes = STATEMACHINE_MPSC_LANES, size_t LaneCapacity = STATEMACHINE_MPSC_LANE_SIZE>
+class mpscEventQueue {
+    static_assert(Lanes > 0, "mpscEventQueue needs at least one lane");
+    static_assert(LaneCapacity >= 2 && (LaneCapacity & (LaneCapacity - 1)) == 0,
+                  "mpscEventQueue lane capacity must be a power of two");
+
+public:
+    mpscEventQueue() : _registeredLanes(0), _nextLane(0), _drained(0), _maxLatency(0), _totalLatency(0) {}
+
+    // Hands out lane IDs to producers; returns -1 once every lane is taken.
+    // Producers may instead use fixed lane IDs, one producer per lane.
+    int registerProducer() {
+        uint32_t lane = _registeredLanes.fetch_add(1, std::memory_order_relaxed);
+        return (lane < Lanes) ? static_cast<int>(lane) : -1;
+    }
+
+    // Producer side, from the lane's single producer only
+    bool push(size_t lane, uint8_t event, void* context) {
+        if (lane >= Lanes) {
+            return false;
+        }
+        laneRing& ring = _lanes[lane];
+        const uint32_t tail = ring.tail.load(std::memory_order_relaxed);
+        const uint32_t depth = tail - ring.head.load(std::memory_order_acquire);
+        if (depth >= LaneCapacity) {
+            ring.overflows.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        timedQueuedEvent& slot = ring.slots[tail & (LaneCapacity - 1)];
+        slot.event = event;
+        slot.context = context;
+        slot.postedAt = static_cast<uint32_t>(micros());
+        ring.tail.store(tail + 1, std::memory_order_release);
+        // Only this producer writes the lane's counters
+        ring.enqueued.store(ring.enqueued.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        if (depth + 1 > ring.highWater.load(std::memory_order_relaxed)) {
+            ring.highWater.store(depth + 1, std::memory_order_relaxed);
+        }
+        return true;
+    }
+
+    // Consumer side: one event per non-empty lane per round until maxCount or empty
+    template <typename Machine>
+    uint16_t drainInto(Machine& machine, size_t maxCount = Lanes * LaneCapacity) {
+        uint16_t mask = 0;
+        size_t count = 0;
+        size_t idleLanes = 0;
+        while (count < maxCount && idleLanes < Lanes) {
+            laneRing& ring = _lanes[_nextLane];
+            _nextLane = (_nextLane + 1 == Lanes) ? 0 : _nextLane + 1;
+
+            const uint32_t head = ring.head.load(std::memory_order_relaxed);
+            if (head == ring.tail.load(std::memory_order_acquire)) {
+                idleLanes++;
+                continue;
+            }
+            idleLanes = 0;
+            timedQueuedEvent queued = ring.slots[head & (LaneCapacity - 1)];
+            ring.head.store(head + 1, std::memory_order_release);
+
+            uint32_t latency = static_cast<uint32_t>(micros()) - queued.postedAt;
+            if (latency > _maxLatency) _maxLatency = latency;
+            _totalLatency += latency;
+            _drained++;
+
+            mask |= machine.processEvent(queued.event, queued.context);
+            count++;
+        }
+        return mask;
+    }
+
+    // Snapshot of one lane's depth; either side may be moving
+    size_t laneDepth(size_t lane) const {
+        const laneRing& ring = _lanes[lane];
+        return ring.tail.load(std::memory_order_acquire) - ring.head.load(std::memory_order_acquire);
+    }
+    size_t size() const {
+        size_t total = 0;
+        for (size_t lane = 0; lane < Lanes; lane++) total += laneDepth(lane);
+        return total;
+    }
+    bool empty() const { return size() == 0; }
+    static constexpr size_t lanes() { return Lanes; }
+    static constexpr size_t laneCapacity() { return LaneCapacity; }
+
+    uint32_t getLaneHighWater(size_t lane) const { return _lanes[lane].highWater.load(std::memory_order_relaxed); }
+
+    // Consumer-side snapshot
+    eventQueueStats getStatistics() const {
+        eventQueueStats stats;
+        for (size_t lane = 0; lane < Lanes; lane++) {
+            stats.enqueued += _lanes[lane].enqueued.load(std::memory_order_relaxed);
+            stats.overflows += _lanes[lane].overflows.load(std::memory_order_relaxed);
+            uint32_t highWater = _lanes[lane].highWater.load(std::memory_order_relaxed);
+            if (highWater > stats.depthHighWater) stats.depthHighWater = highWater;
+        }
+        stats.drained = _drained;
+        stats.maxLatency = _maxLatency;
+        stats.averageLatency = _drained ? static_cast<uint32_t>(_totalLatency / _drained) : 0;
+        return stats;
+    }
+
+private:
+    // Producer-written counters, the consumer-written head and the slots each sit
+    // on their own cache lines, also apart from the neighbouring lanes
+    struct laneRing {
+        std::atomic<uint32_t> tail;
+        std::atomic<uint32_t> enqueued;
+        std::atomic<uint32_t> overflows;
+        std::atomic<uint32_t> highWater;
+        char producerPad[STATEMACHINE_CACHE_LINE_SIZE];
+        std::atomic<uint32_t> head;
+        char consumerPad[STATEMACHINE_CACHE_LINE_SIZE];
+        timedQueuedEvent slots[LaneCapacity];
+        char slotPad[STATEMACHINE_CACHE_LINE_SIZE];
+
+        laneRing() : tail(0), enqueued(0), overflows(0), highWater(0), head(0) {}
+    };
+
+    laneRing _lanes[Lanes];
+    std::atomic<uint32_t> _registeredLanes;
+    size_t _nextLane;
+    uint32_t _drained;
+    uint32_t _maxLatency;
+    uint64_t _totalLatency;
+};
@@ -0,0 +1,61 @@
+#pragma once
+
+// Inline, fixed-capacity string for per-button configuration text.
+//
+// Define STATEMACHINE_FIXED_BUTTON_STRINGS to store buttonValues' config key and
+// value as fixedString<BUTTON_CONFIG_STRING_LENGTH> instead of Arduino Strings.
+// Assigning copies into the inline buffer (truncating to Capacity - 1 characters)
+// and never allocates; copying a pageDefinition is then a plain memberwise copy,
+// so long uptimes cannot fragment the heap through button configuration.
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+template <size_t Capacity>
+class fixedString {
+    static_assert(Capacity > 0 && Capacity <= 256, "fixedString capacity must be 1..256");
+
+public:
+    fixedString() : _length(0) { _buffer[0] = '\0'; }
+    fixedString(const char* text) { assign(text); }
+
+    fixedString& operator=(const char* text) {
+        assign(text);
+        return *this;
+    }
+
+    void assign(const char* text) { assign(text, text ? strlen(text) : 0); }
+
+    void assign(const char* text, size_t length) {
+        if (!text) {
+            length = 0;
+        }
+        if (length > Capacity - 1) {
+            length = Capacity - 1;
+        }
+        if (length) {
+            memmove(_buffer, text, length);
+        }
+        _buffer[length] = '\0';
+        _length = static_cast<uint8_t>(length);
+    }
+
+    void clear() { assign("", 0); }
+
+    const char* c_str() const { return _buffer; }
+    size_t length() const { return _length; }
+    bool isEmpty() const { return _length == 0; }
+    static constexpr size_t capacity() { return Capacity - 1; }
+
+    bool operator==(const char* text) const { return text && strcmp(_buffer, text) == 0; }
+    bool operator!=(const char* text) const { return !(*this == text); }
+    bool operator==(const fixedString& other) const {
+        return _length == other._length && memcmp(_buffer, other._buffer, _length) == 0;
+    }
+    bool operator!=(const fixedString& other) const { return !(*this == other); }
+
+private:
+    char _buffer[Capacity];
+    uint8_t _length;
+};
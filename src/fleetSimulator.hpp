@@ -0,0 +1,213 @@
+#pragma once
+
+// Host-side replay of recorded event streams against many machine instances at once.
+//
+//   std::vector<stateMachineSession<>> units(streamCount, stateMachineSession<>(definition));
+//   std::vector<fleetStream> streams = ...;           // one recorded stream per unit
+//
+//   fleetSimulator simulator;                         // one worker per hardware thread
+//   fleetResult result = simulator.run(units.data(), streams.data(), streams.size());
+//   printf("%.0f events/s per worker\n", result.eventsPerSecondPerWorker());
+//
+// A unit is anything with processEvent(eventID, void*), getStatistics() and
+// getScoreboard(uint8_t): improvedStateMachine and stateMachineSession both fit.
+// Unit i replays streams[i] in order on one thread; different units run in
+// parallel, so units must not share mutable state (actions included).
+//
+// Scheduling is work stealing over unit indices. Each worker starts with a
+// contiguous block of units packed as [begin, end) in one atomic word on its own
+// cache line; it takes units from the front and, once empty, steals the back half
+// of the fullest other block with a single CAS. No work is created after start,
+// so a worker exits when a full scan finds nothing left to steal.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include <thread>
+#include <vector>
+#include "eventQueue.hpp"
+#include "improvedStateMachine.hpp"
+
+// One recorded stream; context is passed to every processEvent call
+struct fleetStream {
+    const eventID* events;
+    size_t count;
+    void* context;
+
+    fleetStream() : events(nullptr), count(0), context(nullptr) {}
+    fleetStream(const eventID* streamEvents, size_t streamCount, void* streamContext = nullptr)
+        : events(streamEvents), count(streamCount), context(streamContext) {}
+};
+
+struct fleetWorkerStats {
+    uint64_t events;
+    uint32_t units;
+    uint32_t steals;
+
+    fleetWorkerStats() : events(0), units(0), steals(0) {}
+};
+
+// Counters are summed over the fleet, maxTransitionTime is the fleet maximum and the
+// scoreboard is the union of every unit's visited pages
+struct fleetResult {
+    uint64_t totalEvents;
+    double elapsedSeconds;
+    stateMachineStats stats;
+    uint32_t scoreboard[STATEMACHINE_SCOREBOARD_NUM_SEGMENTS];
+    std::vector<fleetWorkerStats> workers;
+
+    fleetResult() : totalEvents(0), elapsedSeconds(0) {
+        for (int i = 0; i < STATEMACHINE_SCOREBOARD_NUM_SEGMENTS; i++) {
+            scoreboard[i] = 0;
+        }
+    }
+
+    double eventsPerSecond() const { return elapsedSeconds > 0 ? totalEvents / elapsedSeconds : 0; }
+    double eventsPerSecondPerWorker() const {
+        return workers.empty() ? 0 : eventsPerSecond() / workers.size();
+    }
+};
+
+class fleetSimulator {
+public:
+    // 0 uses one worker per hardware thread
+    explicit fleetSimulator(unsigned workerCount = 0) : _workerCount(workerCount) {
+        if (_workerCount == 0) {
+            _workerCount = std::thread::hardware_concurrency();
+        }
+        if (_workerCount == 0) {
+            _workerCount = 1;
+        }
+    }
+
+    unsigned getWorkerCount() const { return _workerCount; }
+
+    // Replays streams[i] into units[i] for every i < count; the calling thread is worker 0
+    template <typename Unit>
+    fleetResult run(Unit* units, const fleetStream* streams, size_t count) {
+        const unsigned workers = static_cast<unsigned>(
+            std::max<size_t>(1, std::min<size_t>(_workerCount, count)));
+        std::vector<workerBlock> blocks(workers);
+        for (unsigned w = 0; w < workers; w++) {
+            blocks[w].range.store(pack(static_cast<uint32_t>(count * w / workers),
+                                       static_cast<uint32_t>(count * (w + 1) / workers)),
+                                  std::memory_order_relaxed);
+        }
+
+        fleetResult result;
+        result.workers.resize(workers);
+        const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        std::vector<std::thread> threads;
+        threads.reserve(workers - 1);
+        for (unsigned w = 1; w < workers; w++) {
+            threads.push_back(std::thread(&fleetSimulator::work<Unit>, units, streams, &blocks[0], workers, w,
+                                          &result.workers[w]));
+        }
+        work(units, streams, &blocks[0], workers, 0, &result.workers[0]);
+        for (size_t t = 0; t < threads.size(); t++) {
+            threads[t].join();
+        }
+        result.elapsedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        for (size_t w = 0; w < result.workers.size(); w++) {
+            result.totalEvents += result.workers[w].events;
+        }
+        for (size_t i = 0; i < count; i++) {
+            const stateMachineStats stats = units[i].getStatistics();
+            result.stats.totalTransitions += stats.totalTransitions;
+            result.stats.failedTransitions += stats.failedTransitions;
+            result.stats.stateChanges += stats.stateChanges;
+            result.stats.actionExecutions += stats.actionExecutions;
+            result.stats.validationErrors += stats.validationErrors;
+            result.stats.deferredOverflows += stats.deferredOverflows;
+            result.stats.maxTransitionTime = std::max(result.stats.maxTransitionTime, stats.maxTransitionTime);
+            for (uint8_t s = 0; s < STATEMACHINE_SCOREBOARD_NUM_SEGMENTS; s++) {
+                result.scoreboard[s] |= units[i].getScoreboard(s);
+            }
+        }
+        return result;
+    }
+
+private:
+    struct workerBlock {
+        std::atomic<uint64_t> range;
+        char pad[STATEMACHINE_CACHE_LINE_SIZE];
+        workerBlock() : range(0) {}
+    };
+
+    static uint64_t pack(uint32_t begin, uint32_t end) { return (static_cast<uint64_t>(end) << 32) | begin; }
+    static uint32_t beginOf(uint64_t range) { return static_cast<uint32_t>(range); }
+    static uint32_t endOf(uint64_t range) { return static_cast<uint32_t>(range >> 32); }
+
+    // Owner side: takes the front unit of its own block
+    static bool takeFront(workerBlock& block, uint32_t& index) {
+        uint64_t range = block.range.load(std::memory_order_acquire);
+        while (beginOf(range) < endOf(range)) {
+            if (block.range.compare_exchange_weak(range, pack(beginOf(range) + 1, endOf(range)),
+                                                  std::memory_order_acq_rel)) {
+                index = beginOf(range);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Thief side: moves the back half of the fullest other block into self
+    static bool steal(workerBlock* blocks, unsigned workers, unsigned self) {
+        for (;;) {
+            unsigned victim = workers;
+            uint32_t most = 0;
+            for (unsigned w = 0; w < workers; w++) {
+                const uint64_t range = blocks[w].range.load(std::memory_order_relaxed);
+                if (w != self && endOf(range) - beginOf(range) > most) {
+                    most = endOf(range) - beginOf(range);
+                    victim = w;
+                }
+            }
+            if (victim == workers) {
+                return false;
+            }
+            uint64_t range = blocks[victim].range.load(std::memory_order_acquire);
+            const uint32_t begin = beginOf(range);
+            const uint32_t end = endOf(range);
+            if (begin >= end) {
+                continue;
+            }
+            const uint32_t split = end - (end - begin + 1) / 2;
+            if (blocks[victim].range.compare_exchange_strong(range, pack(begin, split),
+                                                             std::memory_order_acq_rel)) {
+                // Our own block is empty, so no other thread can be changing it
+                blocks[self].range.store(pack(split, end), std::memory_order_release);
+                return true;
+            }
+        }
+    }
+
+    template <typename Unit>
+    static void work(Unit* units, const fleetStream* streams, workerBlock* blocks, unsigned workers,
+                     unsigned self, fleetWorkerStats* stats) {
+        fleetWorkerStats local;
+        for (;;) {
+            uint32_t index;
+            if (!takeFront(blocks[self], index)) {
+                if (!steal(blocks, workers, self)) {
+                    break;
+                }
+                local.steals++;
+                continue;
+            }
+            Unit& unit = units[index];
+            const fleetStream& stream = streams[index];
+            for (size_t e = 0; e < stream.count; e++) {
+                unit.processEvent(stream.events[e], stream.context);
+            }
+            local.events += stream.count;
+            local.units++;
+        }
+        *stats = local;
+    }
+
+    unsigned _workerCount;
+};
@@ -25,6 +25,7 @@ public:
 
 #include <cstdint>
 #include <functional>
+#include "actionDelegate.hpp"
 
 // Forward declarations for opaque types
 // These hide the internal implementation details
@@ -37,7 +38,11 @@ struct iStateMachineStats;
 using iPageID = uint8_t;
 using iButtonID = uint8_t;
 using iEventID = uint8_t;
+#ifdef STATEMACHINE_LIGHTWEIGHT_ACTIONS
+using iActionFunction = actionDelegate;
+#else
 using iActionFunction = std::function<void(iPageID, iEventID, void*)>;
+#endif
 
 // Validation result enum (core-agnostic)
 enum class iValidationResult : uint8_t {
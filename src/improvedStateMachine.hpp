@@ -8,15 +8,89 @@
 #include <cstddef>
 #include <algorithm>
 #include <array>
+#include <bitset>
 #include <functional>
 #include <limits>
+#include <new>
+#include <type_traits>
 #include <utility>
 #include <string>
 
+#include "actionDelegate.hpp"
+#include "eventQueue.hpp"
+#include "fixedString.hpp"
+#include "rcuPointer.hpp"
+#include "seqlock.hpp"
+#include "timerWheel.hpp"
+#include "transitionMatcher.hpp"
+
+// Buffer size constants
+#ifndef PRINTF_BUFFER_SIZE
+    #define PRINTF_BUFFER_SIZE 256
+#endif
+
+#ifndef DESCRIPTION_BUFFER_SIZE
+    #define DESCRIPTION_BUFFER_SIZE 12
+#endif
+
 #ifndef ARDUINO
+#include <cstdarg>
+#include <cstdio>
+#include <iostream>
+
 // Forward declarations for mock functions
 unsigned long millis();
 unsigned long micros();
+
+// Mock Serial for native testing
+class MockSerial {
+public:
+  MockSerial &print(const char *str) {
+    std::cout << str;
+    return *this;
+  }
+  MockSerial &print(int val) {
+    std::cout << val;
+    return *this;
+  }
+  MockSerial &print(long val) {
+    std::cout << val;
+    return *this;
+  }
+  MockSerial &print(unsigned long val) {
+    std::cout << val;
+    return *this;
+  }
+  MockSerial &println(const char *str) {
+    std::cout << str << std::endl;
+    return *this;
+  }
+  MockSerial &println(int val) {
+    std::cout << val << std::endl;
+    return *this;
+  }
+  MockSerial &println(long val) {
+    std::cout << val << std::endl;
+    return *this;
+  }
+  MockSerial &println(unsigned long val) {
+    std::cout << val << std::endl;
+    return *this;
+  }
+  MockSerial &println() {
+    std::cout << std::endl;
+    return *this;
+  }
+  void printf(const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    char buffer[PRINTF_BUFFER_SIZE];
+    vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    std::cout << buffer;
+  }
+};
+static MockSerial Serial;
 #endif
 
 // Static storage configuration - compile-time capacity limits
@@ -25,17 +99,34 @@ unsigned long micros();
 #endif
 
 #ifndef STATEMACHINE_MAX_PAGES
-#define STATEMACHINE_MAX_PAGES 250
-#define DONT_CARE_PAGE STATEMACHINE_MAX_PAGES
+    #define STATEMACHINE_MAX_PAGES 250
 #endif
 
 #ifndef STATEMACHINE_MAX_BUTTONS
     #define STATEMACHINE_MAX_BUTTONS 15
-    #define DONT_CARE_BUTTON STATEMACHINE_MAX_BUTTONS
 #endif
 
 #ifndef STATEMACHINE_MAX_EVENTS
     #define STATEMACHINE_MAX_EVENTS 31
+#endif
+
+// Pages with their own rows that the DISPATCH_TABLE strategy can hold. The table
+// costs (pages + 1) * MaxButtons * MaxEvents indexes, so it is left out unless set.
+#ifndef STATEMACHINE_DISPATCH_TABLE_PAGES
+    #define STATEMACHINE_DISPATCH_TABLE_PAGES 0
+#endif
+
+// Wildcard IDs sit just past the ID ranges set by the macros above. They are
+// global, so every basicStateMachine size shares the same ID space.
+#ifndef DONT_CARE_PAGE
+    #define DONT_CARE_PAGE STATEMACHINE_MAX_PAGES
+#endif
+
+#ifndef DONT_CARE_BUTTON
+    #define DONT_CARE_BUTTON STATEMACHINE_MAX_BUTTONS
+#endif
+
+#ifndef DONT_CARE_EVENT
     #define DONT_CARE_EVENT STATEMACHINE_MAX_EVENTS
 #endif
 
@@ -43,6 +134,24 @@ unsigned long micros();
     #define STATEMACHINE_MAX_RECURSION_DEPTH 10
 #endif
 
+// Timers: pool size, page timeout rules and wheel resolution
+#ifndef STATEMACHINE_MAX_TIMERS
+    #define STATEMACHINE_MAX_TIMERS 16
+#endif
+
+#ifndef STATEMACHINE_MAX_PAGE_TIMEOUTS
+    #define STATEMACHINE_MAX_PAGE_TIMEOUTS 8
+#endif
+
+#ifndef STATEMACHINE_TIMER_TICK_MS
+    #define STATEMACHINE_TIMER_TICK_MS 10
+#endif
+
+// Events raised from inside actions while run-to-completion is enabled
+#ifndef STATEMACHINE_DEFERRED_EVENT_QUEUE_SIZE
+    #define STATEMACHINE_DEFERRED_EVENT_QUEUE_SIZE 8
+#endif
+
 #ifndef STATEMACHINE_SCOREBOARD_SEGMENT_SIZE
     #define STATEMACHINE_SCOREBOARD_SEGMENT_SIZE 32
 #endif
@@ -59,6 +168,23 @@ unsigned long micros();
     #define BUTTON_STRING_LENGTH 4
 #endif
 
+// Inline capacity of button config keys and values with STATEMACHINE_FIXED_BUTTON_STRINGS
+#ifndef BUTTON_CONFIG_STRING_LENGTH
+    #define BUTTON_CONFIG_STRING_LENGTH 16
+#endif
+
+// Pages reserved inside each machine; addState returns MAX_PAGES_EXCEEDED past them.
+// Defining STATEMACHINE_PAGE_POOL_HEAP lets a machine grow past the pool up to MaxPages
+// with heap chunks, and a failed allocation returns PAGE_ALLOCATION_FAILED.
+#ifndef STATEMACHINE_PAGE_POOL_SIZE
+    #define STATEMACHINE_PAGE_POOL_SIZE 32
+#endif
+
+// Pages allocated together when a heap page pool grows
+#ifndef STATEMACHINE_PAGE_POOL_CHUNK
+    #define STATEMACHINE_PAGE_POOL_CHUNK 8
+#endif
+
 #ifndef STATEMACHINE_MAX_KEY_LENGTH
     #define STATEMACHINE_MAX_KEY_LENGTH 12
 #endif
@@ -76,21 +202,26 @@ unsigned long micros();
     #define REDRAW_MASK_FULL 0x0004
 #endif
 
-// Buffer size constants
-#ifndef PRINTF_BUFFER_SIZE
-    #define PRINTF_BUFFER_SIZE 256
-#endif
-
-#ifndef DESCRIPTION_BUFFER_SIZE
-    #define DESCRIPTION_BUFFER_SIZE 12
-#endif
-
 //enum class debugFlag_t {
 //    VERBOSE = 0,
 //    SHOW_PASS = 1,
 //    ALT_UNITY = 2
 //};
 
+// Transition lookup strategies used by processEvent
+enum class lookupStrategy : uint8_t {
+    LINEAR_SCAN = 0,    // Walk the transition table in insertion order
+    DISPATCH_TABLE,     // Compiled (page, button, event) -> transition index table; needs DispatchPages
+    PAGE_INDEX,         // Per-page row buckets merged with the DONT_CARE_PAGE rows
+    PACKED_SCAN         // In-order scan over the packed key arrays only
+};
+
+// Submission lanes for postEvent; HIGH events are drained before any NORMAL event
+enum class eventPriority : uint8_t {
+    NORMAL = 0,
+    HIGH
+};
+
 // Validation results
 enum validationResult {
     VALID = 0,
@@ -109,7 +240,9 @@ enum validationResult {
     CIRCULAR_DEPENDENCY,
     MAX_TRANSITIONS_EXCEEDED,
     MAX_PAGES_EXCEEDED,
-    MAX_MENUS_EXCEEDED
+    MAX_MENUS_EXCEEDED,
+    MACHINE_SEALED,
+    PAGE_ALLOCATION_FAILED
 };
 
 // Menu template types: the value can be used as identifier and mod divisor for rotating button selection
@@ -140,16 +273,64 @@ struct eepromKey {
     }
 };
 
-// Forward declarations
-class improvedStateMachine;
+// Forward declarations. Capacities default to the STATEMACHINE_MAX_* macros:
+//   MaxTransitions - transition table rows
+//   MaxPages       - page definitions with STATEMACHINE_PAGE_POOL_HEAP; otherwise the
+//                    machine holds min(MaxPages, STATEMACHINE_PAGE_POOL_SIZE) pages.
+//                    Page IDs still range up to DONT_CARE_PAGE.
+//   MaxButtons     - buttons covered by the handled-event masks and dispatch table
+//   MaxEvents      - events covered by the handled-event masks and dispatch table
+//   DispatchPages  - pages with their own rows the dispatch table holds (0: no table)
+// Button and event IDs beyond MaxButtons/MaxEvents stay valid and use the table scan.
+template <size_t MaxTransitions = STATEMACHINE_MAX_TRANSITIONS, size_t MaxPages = STATEMACHINE_MAX_PAGES,
+          uint8_t MaxButtons = STATEMACHINE_MAX_BUTTONS, uint8_t MaxEvents = STATEMACHINE_MAX_EVENTS,
+          size_t DispatchPages = STATEMACHINE_DISPATCH_TABLE_PAGES>
+class basicStateMachine;
+
+// The default-sized machine
+using improvedStateMachine = basicStateMachine<>;
 
 // State identifiers
 using pageID = uint8_t;
 using buttonID = uint8_t;
 using eventID = uint8_t;
 
-// Action function type
+static_assert(STATEMACHINE_DEFERRED_EVENT_QUEUE_SIZE > 0 && STATEMACHINE_DEFERRED_EVENT_QUEUE_SIZE <= 255,
+              "STATEMACHINE_DEFERRED_EVENT_QUEUE_SIZE must be 1..255");
+
+// Handled-event masks hold one bit per event ID
+static_assert(STATEMACHINE_MAX_EVENTS <= 32, "STATEMACHINE_MAX_EVENTS must fit in a 32-bit event mask");
+constexpr uint32_t ALL_EVENTS_MASK = static_cast<uint32_t>((1ULL << STATEMACHINE_MAX_EVENTS) - 1);
+
+// Index into a transition table of the given capacity
+template <size_t Capacity>
+using transitionIndexFor = typename std::conditional<(Capacity < 255), uint8_t, uint16_t>::type;
+using transitionIndex = transitionIndexFor<STATEMACHINE_MAX_TRANSITIONS>;
+
+// Dense [page slot][button][event] storage for the DISPATCH_TABLE strategy
+template <typename Index, size_t Slots, uint8_t Buttons, uint8_t Events>
+struct dispatchTableCells {
+    Index cells[Slots][Buttons][Events];
+    Index& at(size_t slot, uint8_t button, uint8_t event) { return cells[slot][button][event]; }
+    Index at(size_t slot, uint8_t button, uint8_t event) const { return cells[slot][button][event]; }
+};
+
+// No table: compileDispatchTable() fails before any cell is touched
+template <typename Index, uint8_t Buttons, uint8_t Events>
+struct dispatchTableCells<Index, 0, Buttons, Events> {
+    Index& at(size_t, uint8_t, uint8_t) { return _none; }
+    Index at(size_t, uint8_t, uint8_t) const { return _none; }
+private:
+    Index _none = Index();
+};
+constexpr transitionIndex NO_TRANSITION = std::numeric_limits<transitionIndex>::max();
+
+// Action function type; STATEMACHINE_LIGHTWEIGHT_ACTIONS selects the non-allocating delegate
+#ifdef STATEMACHINE_LIGHTWEIGHT_ACTIONS
+using actionFunction = actionDelegate;
+#else
 using actionFunction = std::function<void(pageID, eventID, void*)>;
+#endif
 
 // State machine statistics for monitoring
 struct stateMachineStats {
@@ -161,10 +342,11 @@ struct stateMachineStats {
     uint32_t maxTransitionTime;
     uint32_t averageTransitionTime;
     uint32_t lastTransitionTime;
+    uint32_t deferredOverflows;     // Events dropped because the deferred queue was full
     
     stateMachineStats() : totalTransitions(0), failedTransitions(0), stateChanges(0),
                                actionExecutions(0), validationErrors(0), maxTransitionTime(0), 
-                               averageTransitionTime(0), lastTransitionTime(0) {}
+                               averageTransitionTime(0), lastTransitionTime(0), deferredOverflows(0) {}
 };
 
 // State transition definition
@@ -191,6 +373,11 @@ struct stateTransition {
                        action(nullptr), op1(0), op2(0), op3(0) {}
 };
 
+#ifdef STATEMACHINE_LIGHTWEIGHT_ACTIONS
+static_assert(std::is_trivially_copyable<stateTransition>::value,
+              "stateTransition must be trivially copyable with STATEMACHINE_LIGHTWEIGHT_ACTIONS");
+#endif
+
 // Enhanced error context for detailed error reporting
 struct transitionErrorContext {
     validationResult errorCode;
@@ -223,14 +410,20 @@ struct transitionErrorContext {
           conflictingTransition(conflicting), conflictingTransitionIndex(conflictingIndex) {}
 };
 
+// Button config text; STATEMACHINE_FIXED_BUTTON_STRINGS keeps it inline instead of on the heap
+#ifdef STATEMACHINE_FIXED_BUTTON_STRINGS
+using buttonString = fixedString<BUTTON_CONFIG_STRING_LENGTH>;
+#else
+using buttonString = String;
+#endif
+
 // Button values structure - groups all button-related data for a single button
 struct buttonValues {
-    std::pair<String, String> storage;
+    std::pair<buttonString, buttonString> storage;
     char label[BUTTON_STRING_LENGTH];
     eepromKey eepromKeyData;
     
     buttonValues() {
-        storage = std::make_pair(String(""), String(""));
         label[0] = '\0';
         eepromKeyData = eepromKey();
     }
@@ -346,6 +539,16 @@ struct pageErrorContext {
           conflictingPage(conflicting), conflictingPageIndex(conflictingIndex) {}
 };
 
+// Raises event after timeout ms on page; armed on entry, re-armed by each transition
+// committed on the page and cancelled on exit
+struct pageTimeout {
+    pageID page;
+    eventID event;
+    bool repeat;
+    uint32_t timeoutTicks;
+    int32_t handle;
+};
+
 // Current state structure
 struct currentState {
     pageID page;
@@ -358,14 +561,70 @@ struct currentState {
     }
 };
 
+// Consistent view of the machine for readers on another core (see getSnapshot)
+struct stateSnapshot {
+    currentState current;
+    currentState last;
+    uint16_t redrawMask;
+    uint32_t sequence;          // Increments with every published commit
+};
+
+// Called after each committed transition with the states either side of it
+using commitObserver = void (*)(void* user, const currentState& from, const currentState& to, eventID event);
+
 // Static Improved State Machine Class
-class improvedStateMachine {
+template <size_t MaxTransitions, size_t MaxPages, uint8_t MaxButtons, uint8_t MaxEvents, size_t DispatchPages>
+class basicStateMachine {
+    static_assert(MaxTransitions > 0 && MaxPages > 0 && MaxButtons > 0 && MaxEvents > 0,
+                  "basicStateMachine capacities must be non-zero");
+    static_assert(MaxButtons <= DONT_CARE_BUTTON && MaxEvents <= DONT_CARE_EVENT,
+                  "basicStateMachine button/event capacities must not reach the DONT_CARE IDs");
+    static_assert(MaxPages < 255, "basicStateMachine page capacity must leave slot 0xFF free");
+    static_assert(MaxEvents <= 32, "MaxEvents must fit in a 32-bit event mask");
+    static_assert(DispatchPages < 256, "basicStateMachine dispatch table cannot hold more pages than page IDs");
+
+public:
+    using transitionIndex = transitionIndexFor<MaxTransitions>;
+    static constexpr transitionIndex NO_TRANSITION = std::numeric_limits<transitionIndex>::max();
+    static constexpr uint32_t allEventsMask = static_cast<uint32_t>((1ULL << MaxEvents) - 1);
+
 private:
     // Static storage arrays with counters
-    std::array<stateTransition, STATEMACHINE_MAX_TRANSITIONS> _transitions;
-    std::array<pageDefinition, STATEMACHINE_MAX_PAGES> _states;
+    std::array<stateTransition, MaxTransitions> _transitions;
+    
+    // Mirror of the rows' from-fields, one byte plane per field (3 bytes per row);
+    // _transitions is only read on a hit. Every write to a row must update it.
+    transitionKeyPlanes<MaxTransitions> _keys;
     size_t _transitionCount;
+    
+    // Pages: a pageID -> slot map into a pool filled in insertion order. The pool holds
+    // STATEMACHINE_PAGE_POOL_SIZE pages inside the machine; with STATEMACHINE_PAGE_POOL_HEAP
+    // the pages past it come from heap chunks, up to MaxPages. Addresses stay stable
+    // until clearConfiguration().
+    static constexpr uint8_t NO_PAGE_SLOT = 0xFF;
+    static constexpr size_t PAGE_POOL = STATEMACHINE_PAGE_POOL_SIZE < MaxPages ? STATEMACHINE_PAGE_POOL_SIZE : MaxPages;
+    uint8_t _pageSlotOfId[256];
+    std::array<pageDefinition, PAGE_POOL> _pagePool;
+#ifdef STATEMACHINE_PAGE_POOL_HEAP
+    static constexpr size_t PAGE_CAPACITY = MaxPages;
+    static constexpr size_t PAGE_CHUNK = STATEMACHINE_PAGE_POOL_CHUNK;
+    static constexpr size_t PAGE_CHUNK_COUNT = (MaxPages - PAGE_POOL + PAGE_CHUNK - 1) / PAGE_CHUNK;
+    std::array<pageDefinition*, PAGE_CHUNK_COUNT> _pageChunks = {};
+    pageDefinition& pageAt(size_t slot) {
+        return slot < PAGE_POOL ? _pagePool[slot] : _pageChunks[(slot - PAGE_POOL) / PAGE_CHUNK][(slot - PAGE_POOL) % PAGE_CHUNK];
+    }
+    const pageDefinition& pageAt(size_t slot) const {
+        return slot < PAGE_POOL ? _pagePool[slot] : _pageChunks[(slot - PAGE_POOL) / PAGE_CHUNK][(slot - PAGE_POOL) % PAGE_CHUNK];
+    }
+#else
+    static constexpr size_t PAGE_CAPACITY = PAGE_POOL;
+    pageDefinition& pageAt(size_t slot) { return _pagePool[slot]; }
+    const pageDefinition& pageAt(size_t slot) const { return _pagePool[slot]; }
+#endif
     size_t _stateCount;
+    validationResult storePage(const pageDefinition& page);
+    validationResult copyPagesFrom(const basicStateMachine& other);
+    void releasePages();
     
     currentState _currentState;
     currentState _lastState;
@@ -375,6 +634,73 @@ private:
     uint8_t _recursionDepth;
     stateMachineStats _stats;
     
+    // Run-to-completion: events raised by actions wait here until the current transition commits
+    bool _runToCompletion;
+    uint8_t _deferredHead;
+    uint8_t _deferredCount;
+    queuedEvent _deferredEvents[STATEMACHINE_DEFERRED_EVENT_QUEUE_SIZE];
+    
+    // Page slots, assigned incrementally to pages that own page-specific transitions.
+    // Slot 0 serves every other page and only sees the DONT_CARE_PAGE rows. A page takes
+    // a slot with its first row, so one slot per row (at most one per page ID) never runs out.
+    static constexpr size_t PAGE_SLOTS = (MaxTransitions < 255 ? MaxTransitions : 255) + 1;
+    uint16_t _pageSlotCount;
+    uint8_t _transitionPageSlot[256];
+    uint32_t _handledEvents[PAGE_SLOTS][MaxButtons];
+    
+    // Compiled dispatch table, indexed by page slot: slot 0 plus DispatchPages slots,
+    // or no storage at all when DispatchPages is 0
+    static constexpr size_t DISPATCH_SLOTS = DispatchPages ? DispatchPages + 1 : 0;
+    lookupStrategy _lookupStrategy;
+    bool _dispatchTableDirty;
+    bool _dispatchTableValid;
+    dispatchTableCells<transitionIndex, DISPATCH_SLOTS, MaxButtons, MaxEvents> _dispatchTable;
+    
+    // Page index (CSR layout): rows of page p are _pageIndexRows[_pageIndexOffsets[p] .. _pageIndexOffsets[p + 1])
+    bool _pageIndexDirty;
+    transitionIndex _pageIndexOffsets[257];
+    transitionIndex _pageIndexRows[MaxTransitions];
+    transitionIndex _wildcardRows[MaxTransitions];
+    transitionIndex _wildcardRowCount;
+    
+    // Set by seal(): configuration is frozen and every index is built
+    bool _sealed;
+    std::bitset<MaxTransitions> _sealDuplicates;   // seal() scratch: rows repeated verbatim
+    
+    // Events posted from interrupts or other threads, run by drainEvents()
+    spscEventQueue<STATEMACHINE_EVENT_QUEUE_SIZE> _eventQueue;
+    spscEventQueue<STATEMACHINE_PRIORITY_QUEUE_SIZE, timedQueuedEvent> _priorityQueue;
+    bool _priorityGlobalDispatch;
+    uint32_t _priorityLatencyMax;
+    
+    // Page timeouts and scheduled events, fired by updateTimers()
+    timerWheel<STATEMACHINE_MAX_TIMERS> _timers;
+    uint32_t (*_timerClock)();
+    pageTimeout _pageTimeouts[STATEMACHINE_MAX_PAGE_TIMEOUTS];
+    uint8_t _pageTimeoutCount;
+    
+    commitObserver _commitObserver;
+    void* _commitObserverUser;
+    
+    // State published for concurrent readers at every commit
+    seqlock<stateSnapshot> _snapshot;
+    uint32_t _commitSequence;
+    void publishSnapshot(uint16_t mask) {
+        stateSnapshot snapshot;
+        snapshot.current = _currentState;
+        snapshot.last = _lastState;
+        snapshot.redrawMask = mask;
+        snapshot.sequence = ++_commitSequence;
+        _snapshot.publish(snapshot);
+    }
+    
+    // Button slot of a configured page, or nullptr
+    buttonValues* findButtonValues(pageID pageId, buttonID buttonId);
+    
+    // Published replacement table matched by dispatchEvent (see attachLiveTable)
+    rcuPointer<basicStateMachine>* _liveTable;
+    int _liveReader;
+    
     // Enhanced error reporting
     size_t _addTransitionCallSequence;
     size_t _addStateCallSequence;
@@ -382,7 +708,31 @@ private:
     pageErrorContext _lastPageErrorContext;
     
     // Helper methods
-    bool matchesTransition(const stateTransition& trans, const currentState& state, eventID event) const;
+    bool matchesTransition(size_t index, uint32_t stateKey) const { return _keys.matches(index, stateKey); }
+    transitionIndex findTransition(const currentState& state, eventID event);
+    uint16_t dispatchEvent(eventID event, void* context, bool globalFirst = false);
+    uint16_t processPriorityEvent(eventID event, void* context);
+    transitionIndex findGlobalTransition(const currentState& state, eventID event);
+    uint16_t runDeferredEvents();
+    uint32_t currentTimerTick() const;
+    static uint32_t msToTicks(uint32_t ms) { return (ms + STATEMACHINE_TIMER_TICK_MS - 1) / STATEMACHINE_TIMER_TICK_MS; }
+    void updatePageTimers(pageID previous, pageID current);
+    void notePageChange(pageID previous, pageID current) {
+        if (_pageTimeoutCount) updatePageTimers(previous, current);
+    }
+    bool hasPageTimeout(pageID page) const;
+    uint16_t commitCoalescedRun(const currentState& from, const currentState& to, eventID event);
+    void appendTransition(const stateTransition& transition);
+    void indexTransition(const stateTransition& transition);
+    void resetTransitionIndex();
+    validationResult validateTransition(const stateTransition& trans, size_t priorRows, bool checkConflicts,
+                                        bool verbose) const;
+    transitionIndex findInPageIndex(const currentState& state, uint32_t stateKey) const;
+    bool isEventHandled(const currentState& state, eventID event) const {
+        // Unindexed buttons/events are never rejected early
+        if (state.button >= MaxButtons || event >= MaxEvents) return true;
+        return (_handledEvents[_transitionPageSlot[state.page]][state.button] >> event) & 1UL;
+    }
     bool transitionsConflict(const stateTransition& existing, const stateTransition& newTrans) const;
     void executeAction(const stateTransition& trans, eventID event, void* context);
     uint16_t calculateRedrawMask(const currentState& oldState, const currentState& newState) const;
@@ -395,11 +745,17 @@ private:
     void updateStatistics(uint32_t transitionTime, bool success);
     
 public:
-    improvedStateMachine();
+    basicStateMachine();
     
-    // Copy constructor and assignment operator
-    improvedStateMachine(const improvedStateMachine& other);
-    improvedStateMachine& operator=(const improvedStateMachine& other);
+    // Copy constructor and assignment operator. If a page cannot be stored, the copy
+    // keeps the pages before it and getLastErrorContext() holds the reason
+    // (PAGE_ALLOCATION_FAILED with a heap page pool).
+    basicStateMachine(const basicStateMachine& other);
+    basicStateMachine& operator=(const basicStateMachine& other);
+    ~basicStateMachine() {
+        attachLiveTable(nullptr);
+        releasePages();
+    }
     
     // Configuration methods
     validationResult addState(const stateDefinition& state);
@@ -411,18 +767,20 @@ public:
     void resetAllRuntime();
     
     // Capacity queries
-    size_t getMaxTransitions() const { return STATEMACHINE_MAX_TRANSITIONS; }
-    size_t getMaxStates() const { return STATEMACHINE_MAX_PAGES; }
+    size_t getMaxTransitions() const { return MaxTransitions; }
+    size_t getMaxStates() const { return PAGE_CAPACITY; }
     size_t getTransitionCount() const { return _transitionCount; }
     size_t getStateCount() const { return _stateCount; }
-    size_t getAvailableTransitions() const { return STATEMACHINE_MAX_TRANSITIONS - _transitionCount; }
-    size_t getAvailableStates() const { return STATEMACHINE_MAX_PAGES - _stateCount; }
+    size_t getAvailableTransitions() const { return MaxTransitions - _transitionCount; }
+    size_t getAvailableStates() const { return PAGE_CAPACITY - _stateCount; }
     
     // Safety methods
     void enableValidation(bool enabled = true) { _validationEnabled = enabled; }
     void setValidationEnabled(bool enabled) { _validationEnabled = enabled; }
     bool isValidationEnabled() const { return _validationEnabled; }
     validationResult validateConfiguration() const;
+    // One machine runs one event at a time, so its counters have a single writer and
+    // are not sharded; shardedStatistics::add() folds them into fleet totals
     stateMachineStats getStatistics() const { return _stats; }
     void resetStatistics() { _stats = stateMachineStats(); }
     
@@ -435,6 +793,132 @@ public:
     // Event processing
     uint16_t processEvent(eventID event, void* context = nullptr);
     
+    // Run-to-completion: processEvent calls made from inside an action are queued and
+    // run after the current transition commits, in order, without recursing. The
+    // returned mask includes them. Events beyond STATEMACHINE_DEFERRED_EVENT_QUEUE_SIZE
+    // are dropped and counted in stateMachineStats::deferredOverflows.
+    // Off by default: existing actions that call processEvent expect the nested
+    // transition to have happened when the call returns, so the recursive path and
+    // its STATEMACHINE_MAX_RECURSION_DEPTH cap stay for them. With the mode on, the
+    // depth counter only marks "inside an action" and nesting never exceeds one.
+    void enableRunToCompletion(bool enabled = true) { _runToCompletion = enabled; }
+    bool isRunToCompletionEnabled() const { return _runToCompletion; }
+    size_t getDeferredEventCount() const { return _deferredCount; }
+    
+    // Timers, serviced by calling updateTimers() from the loop; expired timers run
+    // through processEvent in expiry order and the OR-ed redraw mask is returned.
+    // Page timeouts are armed on entering their page, restarted by every transition
+    // committed while on it (an idle timeout) and cancelled on leaving it; repeat
+    // re-raises the event every timeout ms while the page stays current.
+    // Resolution is STATEMACHINE_TIMER_TICK_MS; a timer fires at most once per call.
+    bool addPageTimeout(pageID page, uint32_t timeoutMs, eventID event, bool repeat = false);
+    void clearPageTimeouts();
+    int32_t scheduleEvent(uint32_t delayMs, eventID event, void* context = nullptr, uint32_t periodMs = 0);
+    bool cancelEvent(int32_t handle) { return _timers.cancel(handle); }
+    uint16_t updateTimers();
+    size_t getActiveTimerCount() const { return _timers.activeCount(); }
+    // Millisecond clock for the timers (millis() when null); lets native tests drive time
+    void setTimerClock(uint32_t (*clock)()) { _timerClock = clock; }
+    
+    // One observer slot, called after a transition's action has run and the new state
+    // is committed. Runs inside processEvent like an action does. While it is set,
+    // processEventsCoalesced() commits every step.
+    void setCommitObserver(commitObserver observer, void* user = nullptr) {
+        _commitObserver = observer;
+        _commitObserverUser = user;
+    }
+    
+    // Safe to call from another core or thread while this one processes events:
+    // current and last state, redraw mask and sequence always come from the same
+    // commit. Batches and coalesced runs publish once, with their OR-ed mask.
+    // The plain getters remain for the owning thread.
+    stateSnapshot getSnapshot() const { return _snapshot.read(); }
+    
+    // Hot-swappable transition table. While attached, events are matched against the
+    // version currently published in table (built and sealed off to the side, then
+    // handed to rcuPointer::publish) instead of this machine's own rows. A transition
+    // keeps the version it started with until its action has run and the state is
+    // committed, so publishing never pauses input or exposes a half-built table.
+    // Until a version is published the machine's own rows are used. Claims one
+    // reader slot and returns false when none is free; nullptr detaches.
+    // Attach and detach from the thread that processes events, outside any action.
+    bool attachLiveTable(rcuPointer<basicStateMachine>* table);
+    bool isLiveTableAttached() const { return _liveTable != nullptr; }
+    
+    // Runs count events in order with the same results as repeated processEvent calls;
+    // masksOut (optional) receives each event's redraw mask, the OR-ed mask is returned.
+    // Timing is taken once per batch and recorded as the mean time per event.
+    uint16_t processEvents(const eventID* events, size_t count, uint16_t* masksOut = nullptr,
+                           void* context = nullptr);
+    
+    // Coalescing front-end for bursts of navigation input (e.g. a fast encoder spin).
+    // Consecutive events in navigationEvents (bit n = event n) whose transitions have no
+    // action are folded into one state change; the returned mask covers each folded
+    // run's net movement (a run that ends where it started redraws nothing). A run stops
+    // before a page with a timeout rule and while a commit observer is set, so timers
+    // and waiters see every step they could act on. Everything else runs through
+    // processEvent as usual, after any pending run has been committed.
+    uint16_t processEventsCoalesced(const eventID* events, size_t count, uint32_t navigationEvents,
+                                    void* context = nullptr);
+    
+    // Deferred events: postEvent() may be called from one ISR or producer thread per
+    // lane (mark the calling ISR IRAM_ATTR on ESP32); drainEvents() runs up to maxCount
+    // queued events through processEvent in order and returns the OR-ed redraw mask.
+    // HIGH priority events preempt: every pending HIGH event is dispatched before the
+    // next NORMAL one. With enablePriorityGlobalDispatch() they are matched against the
+    // short list of DONT_CARE_PAGE rows before the full lookup; when validation is off
+    // and rows overlap, the global route therefore wins over page-specific rows.
+    bool postEvent(eventID event, void* context = nullptr, eventPriority priority = eventPriority::NORMAL) {
+        if (priority == eventPriority::HIGH) {
+            timedQueuedEvent item = { event, context, static_cast<uint32_t>(micros()) };
+            return _priorityQueue.push(item);
+        }
+        return _eventQueue.push(event, context);
+    }
+    uint16_t drainEvents(size_t maxCount = STATEMACHINE_EVENT_QUEUE_SIZE);
+    size_t getQueuedEventCount() const { return _eventQueue.size() + _priorityQueue.size(); }
+    size_t getQueuedEventCount(eventPriority lane) const {
+        return (lane == eventPriority::HIGH) ? _priorityQueue.size() : _eventQueue.size();
+    }
+    uint32_t getQueueOverflowCount() const {
+        return _eventQueue.getOverflowCount() + _priorityQueue.getOverflowCount();
+    }
+    uint32_t getQueueOverflowCount(eventPriority lane) const {
+        return (lane == eventPriority::HIGH) ? _priorityQueue.getOverflowCount() : _eventQueue.getOverflowCount();
+    }
+    void enablePriorityGlobalDispatch(bool enabled = true) { _priorityGlobalDispatch = enabled; }
+    bool isPriorityGlobalDispatchEnabled() const { return _priorityGlobalDispatch; }
+    // Worst post-to-dispatch time of a HIGH event, in microseconds
+    uint32_t getPriorityLatencyMax() const { return _priorityLatencyMax; }
+    void resetPriorityLatency() { _priorityLatencyMax = 0; }
+    
+    // Transition lookup (the dispatch table is rebuilt lazily after configuration changes).
+    // compileDispatchTable() fails when more pages own rows than DispatchPages; lookups
+    // then use the page index instead.
+    void setLookupStrategy(lookupStrategy strategy);
+    lookupStrategy getLookupStrategy() const { return _lookupStrategy; }
+    bool compileDispatchTable();
+    bool isDispatchTableCompiled() const { return _dispatchTableValid && !_dispatchTableDirty; }
+    void buildPageIndex();
+    bool isPageIndexBuilt() const { return !_pageIndexDirty; }
+    
+    // Validate the whole table once, drop exact duplicates, build every index and
+    // freeze the configuration. While sealed, addTransition/addState return
+    // MACHINE_SEALED and processEvent skips all rebuild checks; unseal() or a
+    // clear* call reopens the machine. Pass false to keep overlapping rows that
+    // rely on first-match priority (only exact duplicates are then removed).
+    validationResult seal(bool checkConflicts = true);
+    void unseal() { _sealed = false; }
+    bool isSealed() const { return _sealed; }
+    
+    // Read-only first-match lookup without touching any runtime state, so one sealed
+    // machine can serve many readers (see sharedStateMachine.hpp). Uses the sealed
+    // indexes, or a scan of the packed keys when unsealed. nullptr when nothing matches.
+    const stateTransition* matchTransition(pageID page, buttonID button, eventID event) const;
+    
+    // Bit n is set when event n has at least one matching transition from page/button
+    uint32_t getHandledEvents(pageID page, buttonID button) const;
+    
     // State queries
     pageID getCurrentPage() const { 
         if (_debugModeVerbose) Serial.printf("Current page: %d\n", _currentState.page);
@@ -458,6 +942,13 @@ public:
     void setButtonConfigValue(pageID pageId, buttonID buttonId, const String& value);
     void setButtonConfigPair(pageID pageId, buttonID buttonId, const String& key, const String& value);
     std::pair<String, String> getButtonConfigPair(pageID pageId, buttonID buttonId) const;
+    // Non-allocating forms: the views point into the page's storage and stay valid
+    // until that button's config is changed ("" when the page or button is unknown)
+    const char* getButtonConfigKeyView(pageID pageId, buttonID buttonId) const;
+    const char* getButtonConfigValueView(pageID pageId, buttonID buttonId) const;
+    void setButtonConfigKey(pageID pageId, buttonID buttonId, const char* key);
+    void setButtonConfigValue(pageID pageId, buttonID buttonId, const char* value);
+    void setButtonConfigPair(pageID pageId, buttonID buttonId, const char* key, const char* value);
     
     // Button label getters and setters
     const char* getButtonLabel(pageID pageId, buttonID buttonId) const;
@@ -537,3 +1028,8 @@ public:
                                 size_t existingIndex) const;
 };
 
+// Member definitions, available to every capacity combination
+#include "improvedStateMachineImpl.hpp"
+
+// The default configuration is compiled once, in improvedStateMachine.cpp
+extern template class basicStateMachine<>;
@@ -0,0 +1,2344 @@
+#pragma once
+
+// Member definitions of basicStateMachine, included at the end of
+// improvedStateMachine.hpp so that any capacity combination can be instantiated.
+
+#include <algorithm>
+#include <cstring>
+
+#define STATEMACHINE_TEMPLATE template <size_t MaxTransitions, size_t MaxPages, uint8_t MaxButtons, uint8_t MaxEvents, size_t DispatchPages>
+#define STATEMACHINE_CLASS basicStateMachine<MaxTransitions, MaxPages, MaxButtons, MaxEvents, DispatchPages>
+
+STATEMACHINE_TEMPLATE
+constexpr typename STATEMACHINE_CLASS::transitionIndex STATEMACHINE_CLASS::NO_TRANSITION;
+
+STATEMACHINE_TEMPLATE
+constexpr uint32_t STATEMACHINE_CLASS::allEventsMask;
+
+STATEMACHINE_TEMPLATE
+STATEMACHINE_CLASS::basicStateMachine()
+    : _transitionCount(0), _stateCount(0), _debugModeVerbose(false), 
+      _validationEnabled(true), _recursionDepth(0),
+      _runToCompletion(false), _deferredHead(0), _deferredCount(0),
+      _lookupStrategy(lookupStrategy::LINEAR_SCAN), _dispatchTableDirty(true),
+      _dispatchTableValid(false), _pageIndexDirty(true),
+      _wildcardRowCount(0), _sealed(false), _priorityGlobalDispatch(false),
+      _priorityLatencyMax(0), _timerClock(nullptr), _pageTimeoutCount(0),
+      _commitObserver(nullptr), _commitObserverUser(nullptr), _commitSequence(0),
+      _liveTable(nullptr), _liveReader(-1),
+      _addTransitionCallSequence(0), _lastErrorContext() {
+  memset(_pageSlotOfId, NO_PAGE_SLOT, sizeof(_pageSlotOfId));
+  resetTransitionIndex();
+  // Initialize scoreboard
+  for (int i = 0; i < STATEMACHINE_SCOREBOARD_NUM_SEGMENTS; i++) {
+    _stateScoreboard[i] = 0;
+  }
+  _stats = stateMachineStats();
+}
+
+// Copy constructor
+STATEMACHINE_TEMPLATE
+STATEMACHINE_CLASS::basicStateMachine(const basicStateMachine& other)
+    : _transitions(other._transitions),
+      _keys(other._keys),
+      _transitionCount(other._transitionCount),
+      _stateCount(0),
+      _currentState(other._currentState),
+      _lastState(other._lastState),
+      _debugModeVerbose(other._debugModeVerbose),
+      _validationEnabled(other._validationEnabled),
+      _recursionDepth(0),  // Reset recursion depth for new instance
+      _stats(other._stats),
+      _runToCompletion(other._runToCompletion),
+      _deferredHead(0),
+      _deferredCount(0),
+      _lookupStrategy(other._lookupStrategy),
+      _dispatchTableDirty(true),  // Rebuilt lazily on first lookup
+      _dispatchTableValid(false),
+      _pageIndexDirty(true),
+      _wildcardRowCount(0),
+      _sealed(false),
+      _priorityGlobalDispatch(other._priorityGlobalDispatch),
+      _priorityLatencyMax(0),
+      _timerClock(other._timerClock),
+      _pageTimeoutCount(0),
+      _commitObserver(nullptr),  // Observers watch one instance
+      _commitObserverUser(nullptr),
+      _commitSequence(0),
+      _liveTable(nullptr),  // A reader slot belongs to one instance
+      _liveReader(-1),
+      _addTransitionCallSequence(0),  // Reset call sequence for new instance
+      _lastErrorContext() {  // Reset error context for new instance
+  memset(_pageSlotOfId, NO_PAGE_SLOT, sizeof(_pageSlotOfId));
+  copyPagesFrom(other);
+  // Rebuild page slots and handled-event masks for the copied transitions
+  resetTransitionIndex();
+  for (size_t i = 0; i < _transitionCount; i++) {
+    indexTransition(_transitions[i]);
+  }
+  // A sealed copy needs its indexes before the first lookup
+  if (other._sealed) {
+    compileDispatchTable();
+    buildPageIndex();
+    _sealed = true;
+  }
+  // Copy scoreboard
+  for (int i = 0; i < STATEMACHINE_SCOREBOARD_NUM_SEGMENTS; i++) {
+    _stateScoreboard[i] = other._stateScoreboard[i];
+  }
+  // Timeout rules are configuration; pending timers are not copied
+  for (uint8_t i = 0; i < other._pageTimeoutCount; i++) {
+    addPageTimeout(other._pageTimeouts[i].page, other._pageTimeouts[i].timeoutTicks * STATEMACHINE_TIMER_TICK_MS,
+                   other._pageTimeouts[i].event, other._pageTimeouts[i].repeat);
+  }
+  publishSnapshot(0);
+}
+
+// Assignment operator
+STATEMACHINE_TEMPLATE
+STATEMACHINE_CLASS& STATEMACHINE_CLASS::operator=(const basicStateMachine& other) {
+  if (this != &other) {
+    _transitions = other._transitions;
+    _keys = other._keys;
+    _transitionCount = other._transitionCount;
+    _currentState = other._currentState;
+    _lastState = other._lastState;
+    _debugModeVerbose = other._debugModeVerbose;
+    _validationEnabled = other._validationEnabled;
+    _recursionDepth = 0;  // Reset recursion depth
+    _stats = other._stats;
+    _runToCompletion = other._runToCompletion;
+    _deferredHead = 0;
+    _deferredCount = 0;
+    _lookupStrategy = other._lookupStrategy;
+    _dispatchTableDirty = true;  // Rebuilt lazily on first lookup
+    _dispatchTableValid = false;
+    _pageIndexDirty = true;
+    _addTransitionCallSequence = 0;  // Reset call sequence for new instance
+    _lastErrorContext = transitionErrorContext();  // Reset error context for new instance
+    copyPagesFrom(other);
+    
+    resetTransitionIndex();
+    for (size_t i = 0; i < _transitionCount; i++) {
+      indexTransition(_transitions[i]);
+    }
+    _sealed = false;
+    if (other._sealed) {
+      compileDispatchTable();
+      buildPageIndex();
+      _sealed = true;
+    }
+    
+    // Copy scoreboard
+    for (int i = 0; i < STATEMACHINE_SCOREBOARD_NUM_SEGMENTS; i++) {
+      _stateScoreboard[i] = other._stateScoreboard[i];
+    }
+    
+    _priorityGlobalDispatch = other._priorityGlobalDispatch;
+    _priorityLatencyMax = 0;
+    _timers.clear();
+    _timerClock = other._timerClock;
+    _pageTimeoutCount = 0;
+    for (uint8_t i = 0; i < other._pageTimeoutCount; i++) {
+      addPageTimeout(other._pageTimeouts[i].page, other._pageTimeouts[i].timeoutTicks * STATEMACHINE_TIMER_TICK_MS,
+                     other._pageTimeouts[i].event, other._pageTimeouts[i].repeat);
+    }
+    publishSnapshot(0);
+  }
+  return *this;
+}
+
+// Configuration methods
+STATEMACHINE_TEMPLATE
+validationResult STATEMACHINE_CLASS::addState(const stateDefinition &state) {
+  if (_sealed) {
+    if (_debugModeVerbose) {
+      Serial.printf("ERROR: Machine is sealed, page %d rejected\n", state.id);
+    }
+    return MACHINE_SEALED;
+  }
+
+  // Check for maximum states
+  if (_stateCount >= PAGE_CAPACITY) {
+    if (_debugModeVerbose) {
+      Serial.printf("ERROR: Maximum states (%d) exceeded\n", static_cast<int>(PAGE_CAPACITY));
+    }
+    return MAX_PAGES_EXCEEDED;
+  }
+
+  // Check for duplicate pages
+  if (_pageSlotOfId[state.id] != NO_PAGE_SLOT) {
+    if (_debugModeVerbose) {
+      Serial.printf("ERROR: Duplicate page ID %d\n", state.id);
+    }
+    return DUPLICATE_PAGE;
+  }
+
+  return storePage(state);
+}
+
+STATEMACHINE_TEMPLATE
+const pageDefinition *STATEMACHINE_CLASS::getState(pageID id) const {
+  const uint8_t slot = _pageSlotOfId[id];
+  return (slot == NO_PAGE_SLOT) ? nullptr : &pageAt(slot);
+}
+
+// Appends a page in the next slot; past the inline pool a heap pool allocates a chunk
+STATEMACHINE_TEMPLATE
+validationResult STATEMACHINE_CLASS::storePage(const pageDefinition &page) {
+  if (_stateCount >= PAGE_CAPACITY) {
+    return MAX_PAGES_EXCEEDED;
+  }
+#ifdef STATEMACHINE_PAGE_POOL_HEAP
+  if (_stateCount >= PAGE_POOL) {
+    const size_t chunk = (_stateCount - PAGE_POOL) / PAGE_CHUNK;
+    if (!_pageChunks[chunk]) {
+      _pageChunks[chunk] = new (std::nothrow) pageDefinition[PAGE_CHUNK];
+      if (!_pageChunks[chunk]) {
+        if (_debugModeVerbose) {
+          Serial.printf("ERROR: Out of memory for page %d\n", page.id);
+        }
+        return PAGE_ALLOCATION_FAILED;
+      }
+    }
+  }
+#endif
+  pageAt(_stateCount) = page;
+  _pageSlotOfId[page.id] = static_cast<uint8_t>(_stateCount);
+  _stateCount++;
+  return VALID;
+}
+
+// Replaces this machine's pages with copies of other's, reusing allocated chunks.
+// Stops at the first page that cannot be stored and returns why.
+STATEMACHINE_TEMPLATE
+validationResult STATEMACHINE_CLASS::copyPagesFrom(const basicStateMachine &other) {
+  memset(_pageSlotOfId, NO_PAGE_SLOT, sizeof(_pageSlotOfId));
+  _stateCount = 0;
+  for (size_t i = 0; i < other._stateCount; i++) {
+    validationResult result = storePage(other.pageAt(i));
+    if (result != VALID) {
+      _lastErrorContext = transitionErrorContext(result, stateTransition(), 0, 0, "copyPages");
+      _stats.validationErrors++;
+      return result;
+    }
+  }
+  return VALID;
+}
+
+STATEMACHINE_TEMPLATE
+void STATEMACHINE_CLASS::releasePages() {
+  // Drop what the used pages hold (button strings) so a reused machine starts clean
+  for (size_t i = 0; i < _stateCount && i < PAGE_POOL; i++) {
+    _pagePool[i] = pageDefinition();
+  }
+#ifdef STATEMACHINE_PAGE_POOL_HEAP
+  for (size_t i = 0; i < PAGE_CHUNK_COUNT; i++) {
+    delete[] _pageChunks[i];
+    _pageChunks[i] = nullptr;
+  }
+#endif
+  memset(_pageSlotOfId, NO_PAGE_SLOT, sizeof(_pageSlotOfId));
+  _stateCount = 0;
+}
+
+STATEMACHINE_TEMPLATE
+void STATEMACHINE_CLASS::setDebugMode(bool value) { 
+                _debugModeVerbose = value;
+    }
+
+STATEMACHINE_TEMPLATE
+bool STATEMACHINE_CLASS::getDebugMode() const { 
+        return _debugModeVerbose;
+}
+
+STATEMACHINE_TEMPLATE
+validationResult STATEMACHINE_CLASS::addTransition(const stateTransition &transition) {
+  if (_sealed) {
+    if (_debugModeVerbose) {
+      Serial.println("ERROR: Machine is sealed, transition rejected");
+    }
+    return MACHINE_SEALED;
+  }
+
+  // Check for maximum transitions
+  if (_transitionCount >= MaxTransitions) {
+    if (_debugModeVerbose) {
+      Serial.printf("ERROR: Maximum transitions (%d) exceeded\n", static_cast<int>(MaxTransitions));
+    }
+    return MAX_TRANSITIONS_EXCEEDED;
+  }
+
+  // Validate transition if validation is enabled
+  if (_validationEnabled) {
+    validationResult result = validateTransition(transition);
+    if (result != VALID) {
+      if (_debugModeVerbose) {
+        Serial.printf("ERROR: Invalid transition - %s (code %d) at %s:%d\n", 
+                     getErrorDescription(result), static_cast<int>(result), 
+                     __FUNCTION__, __LINE__);
+        
+        // For duplicate transitions, show the conflicting transition details
+        if (result == DUPLICATE_TRANSITION) {
+          stateTransition conflictingTrans;
+          size_t conflictingIndex = 0;
+          validateTransitionWithConflictDetails(transition, conflictingTrans, conflictingIndex, false);
+          printDuplicateTransitionError(transition, conflictingTrans, conflictingIndex);
+        }
+      }
+      
+      // Populate error context for all validation failures
+      _lastErrorContext = transitionErrorContext(result, transition, 
+                                                _transitionCount, _addTransitionCallSequence, __FUNCTION__);
+      
+      _stats.validationErrors++;
+      return result;
+    }
+  }
+
+  appendTransition(transition);
+  return VALID;
+}
+
+STATEMACHINE_TEMPLATE
+validationResult STATEMACHINE_CLASS::addTransition(const stateTransition& transition, const char* location) {
+  _addTransitionCallSequence++;
+  
+  if (_sealed) {
+    _lastErrorContext = transitionErrorContext(MACHINE_SEALED, transition,
+                                              _transitionCount, _addTransitionCallSequence, location);
+    return MACHINE_SEALED;
+  }
+
+  // Check for maximum transitions
+  if (_transitionCount >= MaxTransitions) {
+    if (_debugModeVerbose) {
+      Serial.printf("ERROR: Maximum transitions (%d) exceeded\n", static_cast<int>(MaxTransitions));
+    }
+    
+    // Populate error context
+    _lastErrorContext = transitionErrorContext(MAX_TRANSITIONS_EXCEEDED, transition, 
+                                              _transitionCount, _addTransitionCallSequence, location);
+    return MAX_TRANSITIONS_EXCEEDED;
+  }
+
+  // Validate transition if validation is enabled
+  if (_validationEnabled) {
+    validationResult result = validateTransition(transition);
+    if (result != VALID) {
+      if (_debugModeVerbose) {
+        Serial.printf("ERROR: Invalid transition - %s (code %d) at %s:%d\n", 
+                     getErrorDescription(result), static_cast<int>(result), 
+                     __FUNCTION__, __LINE__);
+        
+        // For duplicate transitions, show the conflicting transition details
+        if (result == DUPLICATE_TRANSITION) {
+          stateTransition conflictingTrans;
+          size_t conflictingIndex = 0;
+          validateTransitionWithConflictDetails(transition, conflictingTrans, conflictingIndex, false);
+          printDuplicateTransitionError(transition, conflictingTrans, conflictingIndex);
+        }
+      }
+      
+      // Populate error context
+      if (result == DUPLICATE_TRANSITION) {
+        stateTransition conflictingTrans;
+        size_t conflictingIndex = 0;
+        validateTransitionWithConflictDetails(transition, conflictingTrans, conflictingIndex, false);
+        _lastErrorContext = transitionErrorContext(result, transition, 
+                                                  _transitionCount, _addTransitionCallSequence, location,
+                                                  conflictingTrans, conflictingIndex);
+      } else {
+        _lastErrorContext = transitionErrorContext(result, transition, 
+                                                  _transitionCount, _addTransitionCallSequence, location);
+      }
+      _stats.validationErrors++;
+      return result;
+    }
+  }
+
+  appendTransition(transition);
+  return VALID;
+}
+
+
+
+STATEMACHINE_TEMPLATE
+void STATEMACHINE_CLASS::appendTransition(const stateTransition& transition) {
+  _transitions[_transitionCount] = transition;
+  _keys.set(_transitionCount, transition.fromPage, transition.fromButton, transition.event,
+            DONT_CARE_PAGE, DONT_CARE_BUTTON, DONT_CARE_EVENT);
+  _transitionCount++;
+  indexTransition(transition);
+  _dispatchTableDirty = true;
+  _pageIndexDirty = true;
+}
+
+STATEMACHINE_TEMPLATE
+void STATEMACHINE_CLASS::resetTransitionIndex() {
+  _pageSlotCount = 1;
+  memset(_transitionPageSlot, 0, sizeof(_transitionPageSlot));
+  memset(_handledEvents, 0, sizeof(_handledEvents));
+}
+
+// Incrementally assign a page slot and OR the transition into the handled-event masks
+STATEMACHINE_TEMPLATE
+void STATEMACHINE_CLASS::indexTransition(const stateTransition& trans) {
+  if (trans.fromPage != DONT_CARE_PAGE && _transitionPageSlot[trans.fromPage] == 0) {
+    // A new page starts with every DONT_CARE_PAGE row already seen
+    uint8_t slot = static_cast<uint8_t>(_pageSlotCount++);
+    _transitionPageSlot[trans.fromPage] = slot;
+    memcpy(_handledEvents[slot], _handledEvents[0], sizeof(_handledEvents[0]));
+  }
+
+  uint32_t eventBits = 0;
+  if (trans.event == DONT_CARE_EVENT) {
+    eventBits = allEventsMask;
+  } else if (trans.event < MaxEvents) {
+    eventBits = 1UL << trans.event;
+  }
+
+  uint16_t firstSlot = 0, lastSlot = _pageSlotCount;
+  if (trans.fromPage != DONT_CARE_PAGE) {
+    firstSlot = _transitionPageSlot[trans.fromPage];
+    lastSlot = firstSlot + 1;
+  }
+
+  uint8_t firstButton = 0, lastButton = MaxButtons;
+  if (trans.fromButton != DONT_CARE_BUTTON) {
+    if (trans.fromButton >= MaxButtons) return;
+    firstButton = trans.fromButton;
+    lastButton = firstButton + 1;
+  }
+
+  for (uint16_t slot = firstSlot; slot < lastSlot; slot++) {
+    for (uint8_t button = firstButton; button < lastButton; button++) {
+      _handledEvents[slot][button] |= eventBits;
+    }
+  }
+}
+
+STATEMACHINE_TEMPLATE
+uint32_t STATEMACHINE_CLASS::getHandledEvents(pageID page, buttonID button) const {
+  if (button < MaxButtons) {
+    return _handledEvents[_transitionPageSlot[page]][button];
+  }
+
+  // Not indexed: derive the mask from the table
+  uint32_t mask = 0;
+  for (size_t i = 0; i < _transitionCount; i++) {
+    const auto& trans = _transitions[i];
+    if ((trans.fromPage == DONT_CARE_PAGE || trans.fromPage == page) &&
+        (trans.fromButton == DONT_CARE_BUTTON || trans.fromButton == button)) {
+      if (trans.event == DONT_CARE_EVENT) {
+        mask |= allEventsMask;
+      } else if (trans.event < MaxEvents) {
+        mask |= 1UL << trans.event;
+      }
+    }
+  }
+  return mask;
+}
+
+// Clear methods for reuse
+STATEMACHINE_TEMPLATE
+void STATEMACHINE_CLASS::clearConfiguration() {
+  _sealed = false;
+  _transitionCount = 0;
+  releasePages();
+  resetTransitionIndex();
+  _dispatchTableDirty = true;
+  _pageIndexDirty = true;
+  _pageTimeoutCount = 0;
+  resetAllRuntime();
+}
+
+STATEMACHINE_TEMPLATE
+void STATEMACHINE_CLASS::clearTransitions() {
+  _sealed = false;
+  _transitionCount = 0;
+  resetTransitionIndex();
+  _dispatchTableDirty = true;
+  _pageIndexDirty = true;
+  resetStatistics();
+}
+
+STATEMACHINE_TEMPLATE
+void STATEMACHINE_CLASS::resetAllRuntime() {
+  _stats = stateMachineStats();
+  for (int i = 0; i < STATEMACHINE_SCOREBOARD_NUM_SEGMENTS; i++) {
+    _stateScoreboard[i] = 0;
+  }
+  _recursionDepth = 0;
+  _deferredHead = 0;
+  _deferredCount = 0;
+  _timers.clear();
+  for (uint8_t i = 0; i < _pageTimeoutCount; i++) {
+    _pageTimeouts[i].handle = -1;
+  }
+  _currentState = currentState();
+  _lastState = currentState();
+  publishSnapshot(0);
+}
+
+// State management
+STATEMACHINE_TEMPLATE
+void STATEMACHINE_CLASS::initializeState(pageID page, buttonID button) {
+  notePageChange(_currentState.page, page);
+  _currentState.page = page;
+  _currentState.button = button;
+  _lastState = _currentState;
+  publishSnapshot(0);
+
+  if (_debugModeVerbose) {
+    Serial.printf("Initial state set: %d/%d\n", page, button);
+  }
+}
+
+STATEMACHINE_TEMPLATE
+void STATEMACHINE_CLASS::setState(pageID page, buttonID button) {
+  _lastState = _currentState;
+  _currentState.page = page;
+  _currentState.button = button;
+  notePageChange(_lastState.page, page);
+  publishSnapshot(calculateRedrawMask(_lastState, _currentState));
+
+  if (_debugModeVerbose) {
+    Serial.printf("State changed to: %d/%d\n", page, button);
+  }
+}
+
+STATEMACHINE_TEMPLATE
+void STATEMACHINE_CLASS::setCurrentPage(pageID page) {
+  _lastState = _currentState;
+  _currentState.page = page;
+  notePageChange(_lastState.page, page);
+  publishSnapshot(calculateRedrawMask(_lastState, _currentState));
+
+  if (_debugModeVerbose) {
+    Serial.printf("Current page ID set to: %d\n", page);
+  }
+}
+
+STATEMACHINE_TEMPLATE
+void STATEMACHINE_CLASS::forceState(pageID page, buttonID button) {
+  setState(page, button);
+}
+
+// Event processing with safety checks
+STATEMACHINE_TEMPLATE
+uint16_t STATEMACHINE_CLASS::processEvent(eventID event, void *context) {
+  // Both paths are intended: without run-to-completion an action's processEvent
+  // recurses (bounded by STATEMACHINE_MAX_RECURSION_DEPTH in dispatchEvent)
+  if (_recursionDepth > 0 && _runToCompletion) {
+    // Raised from inside an action: runs once the current transition has committed
+    if (_deferredCount >= STATEMACHINE_DEFERRED_EVENT_QUEUE_SIZE) {
+      _stats.deferredOverflows++;
+      _stats.failedTransitions++;
+      return 0;
+    }
+    queuedEvent &slot = _deferredEvents[(_deferredHead + _deferredCount) % STATEMACHINE_DEFERRED_EVENT_QUEUE_SIZE];
+    slot.event = event;
+    slot.context = context;
+    _deferredCount++;
+    return 0;
+  }
+
+  uint16_t mask = dispatchEvent(event, context);
+  if (_deferredCount > 0 && _recursionDepth == 0) {
+    mask |= runDeferredEvents();
+  }
+  return mask;
+}
+
+// Runs deferred events iteratively, including any their actions raise
+STATEMACHINE_TEMPLATE
+uint16_t STATEMACHINE_CLASS::runDeferredEvents() {
+  uint16_t mask = 0;
+  while (_deferredCount > 0) {
+    queuedEvent next = _deferredEvents[_deferredHead];
+    _deferredHead = (_deferredHead + 1) % STATEMACHINE_DEFERRED_EVENT_QUEUE_SIZE;
+    _deferredCount--;
+    mask |= dispatchEvent(next.event, next.context);
+  }
+  return mask;
+}
+
+// One transition: lookup, action, state commit and statistics
+STATEMACHINE_TEMPLATE
+uint16_t STATEMACHINE_CLASS::dispatchEvent(eventID event, void *context, bool globalFirst) {
+  // Check for maximum recursion depth to prevent stack overflow
+  if (_recursionDepth >= STATEMACHINE_MAX_RECURSION_DEPTH) {
+    if (_debugModeVerbose) {
+      Serial.printf("ERROR: Maximum recursion depth exceeded (%d)\n", _recursionDepth);
+    }
+    _stats.failedTransitions++;
+    return 0;
+  }
+
+  _recursionDepth++;
+  _stats.totalTransitions++;
+
+  // Pins the published table (if any) until this transition has committed
+  typename rcuPointer<basicStateMachine>::readGuard live(_liveTable, _liveReader);
+
+  if (event >= DONT_CARE_EVENT) {
+    if (_debugModeVerbose) {
+      Serial.printf("ERROR: Invalid Event - %d\n", event);
+    }
+    _stats.failedTransitions++;
+    _recursionDepth--;
+    return 0;
+  }
+
+  // Reject events the current page/button does not handle before any timing work
+  if (!_debugModeVerbose && !live.get() && !isEventHandled(_currentState, event)) {
+    _stats.failedTransitions++;
+    _recursionDepth--;
+    return 0;
+  }
+
+  uint32_t startTime = micros();
+
+  if (_debugModeVerbose) {
+    Serial.printf("Processing event %d from state %d/%d\n", event,
+                  _currentState.page, _currentState.button);
+  }
+
+  // Find first matching transition
+  const stateTransition *matchingTransition = nullptr;
+  int matchCount = 0;
+  if (live.get()) {
+    matchingTransition = live->matchTransition(_currentState.page, _currentState.button, event);
+    matchCount = matchingTransition ? 1 : 0;
+  } else if (!_debugModeVerbose) {
+    transitionIndex index = globalFirst ? findGlobalTransition(_currentState, event) : NO_TRANSITION;
+    if (index == NO_TRANSITION) {
+      index = findTransition(_currentState, event);
+    }
+    if (index != NO_TRANSITION) {
+      matchingTransition = &_transitions[index];
+    }
+  } else {
+    // Verbose mode walks the whole table to report ambiguous matches
+    uint32_t stateKey = packTransitionKey(_currentState.page, _currentState.button, event);
+    for (size_t i = 0; i < _transitionCount; i++) {
+      if (matchesTransition(i, stateKey)) {
+        matchingTransition = &_transitions[i];
+        matchCount++;
+      }
+    }
+  }
+
+  if (matchCount > 1) {
+    if (_debugModeVerbose) {
+      Serial.printf("ERROR: Multiple matching transitions found (%d)\n", matchCount);
+      matchingTransition = nullptr;
+    }
+  } else if (matchCount == 0) {
+    if (_debugModeVerbose) {
+      Serial.printf("ERROR: No matching transition found\n");
+      matchingTransition = nullptr;
+    }
+  }
+
+  if (matchingTransition) {
+    const stateTransition &trans = *matchingTransition;
+    if (_debugModeVerbose) {
+      Serial.printf("Found matching transition\n");
+      printTransition(trans);
+    }
+
+    // Execute action with exception safety
+    try {
+      executeAction(trans, event, context);
+    } catch (...) {
+      if (_debugModeVerbose) {
+        Serial.println("ERROR: Exception in action execution");
+      }
+      _stats.failedTransitions++;
+      _recursionDepth--;
+      return 0;
+    }
+
+    _stats.actionExecutions++;
+
+    // Store last state
+    _lastState = _currentState;
+
+    // Create new state from transition
+    currentState newState;
+    newState.page = trans.toPage;
+    newState.button = trans.toButton;
+
+    // Update current state
+    _currentState = newState;
+    _stats.stateChanges++;
+    notePageChange(_lastState.page, _currentState.page);
+
+    // Update scoreboard for the new state
+    updateScoreboard(_currentState.page);
+
+    // Calculate redraw mask
+    uint16_t mask = calculateRedrawMask(_lastState, _currentState);
+
+    if (_debugModeVerbose) {
+      Serial.printf("New state: %d/%d, mask: 0x%04x, scoreboard: %x/%x/%x/%x\n",
+                    _currentState.page, _currentState.button, mask,
+                    _stateScoreboard[0], _stateScoreboard[1],
+                    _stateScoreboard[2], _stateScoreboard[3]);
+    }
+
+    // Update timing statistics
+    uint32_t transitionTime = micros() - startTime;
+    updateStatistics(transitionTime, true);
+    publishSnapshot(mask);
+
+    if (_commitObserver) {
+      _commitObserver(_commitObserverUser, _lastState, _currentState, event);
+    }
+
+    _recursionDepth--;
+    return mask;
+  }
+
+  if (_debugModeVerbose) {
+    Serial.printf("No matching transition found for event %d\n", event);
+  }
+
+  _stats.failedTransitions++;
+  updateStatistics(micros() - startTime, false);
+  _recursionDepth--;
+  return 0;
+}
+
+// Batch form of processEvent: recursion, timing and statistics bookkeeping happen once
+// and the current state stays in locals between events
+STATEMACHINE_TEMPLATE
+uint16_t STATEMACHINE_CLASS::processEvents(const eventID *events, size_t count,
+                                           uint16_t *masksOut, void *context) {
+  if (!events || count == 0) {
+    return 0;
+  }
+
+  // Verbose mode keeps the per-event diagnostics; inside an action the events may need
+  // deferring; a live table is matched per event
+  if (_debugModeVerbose || _liveTable || _recursionDepth >= STATEMACHINE_MAX_RECURSION_DEPTH ||
+      (_runToCompletion && _recursionDepth > 0)) {
+    uint16_t mask = 0;
+    for (size_t i = 0; i < count; i++) {
+      uint16_t eventMask = processEvent(events[i], context);
+      if (masksOut) {
+        masksOut[i] = eventMask;
+      }
+      mask |= eventMask;
+    }
+    return mask;
+  }
+
+  _recursionDepth++;
+  uint32_t startTime = micros();
+
+  currentState state = _currentState;
+  currentState last = _lastState;
+  uint32_t failed = 0;
+  uint32_t actions = 0;
+  uint16_t mask = 0;
+
+  for (size_t i = 0; i < count; i++) {
+    const eventID event = events[i];
+    uint16_t eventMask = 0;
+    transitionIndex index = NO_TRANSITION;
+    if (event < DONT_CARE_EVENT && isEventHandled(state, event)) {
+      index = findTransition(state, event);
+    }
+
+    if (index == NO_TRANSITION) {
+      failed++;
+    } else {
+      const stateTransition &trans = _transitions[index];
+      bool succeeded = true;
+      if (trans.action) {
+        // Actions see (and may change) the live state
+        _currentState = state;
+        _lastState = last;
+        try {
+          executeAction(trans, event, context);
+        } catch (...) {
+          succeeded = false;
+        }
+        state = _currentState;
+        last = _lastState;
+      }
+
+      if (succeeded) {
+        actions++;
+        last = state;
+        state.page = trans.toPage;
+        state.button = trans.toButton;
+        updateScoreboard(state.page);
+        notePageChange(last.page, state.page);
+        eventMask = calculateRedrawMask(last, state);
+        if (_commitObserver) {
+          _currentState = state;
+          _lastState = last;
+          _commitObserver(_commitObserverUser, last, state, event);
+          state = _currentState;
+          last = _lastState;
+        }
+      } else {
+        failed++;
+      }
+
+      // Events the action raised in run-to-completion mode run before the next batch entry
+      if (_deferredCount > 0) {
+        _currentState = state;
+        _lastState = last;
+        eventMask |= runDeferredEvents();
+        state = _currentState;
+        last = _lastState;
+      }
+    }
+
+    if (masksOut) {
+      masksOut[i] = eventMask;
+    }
+    mask |= eventMask;
+  }
+
+  _currentState = state;
+  _lastState = last;
+  if (actions > 0) {
+    publishSnapshot(mask);
+  }
+  _stats.totalTransitions += count;
+  _stats.failedTransitions += failed;
+  _stats.actionExecutions += actions;
+  _stats.stateChanges += actions;
+  if (actions > 0) {
+    updateStatistics((micros() - startTime) / actions, true);
+  }
+  _recursionDepth--;
+  return mask;
+}
+
+// Action-free navigation transitions only move the state, so a run of them can be
+// walked in locals and committed once; the scoreboard still sees every page visited.
+// A step is only folded when nothing needs to see its own commit: no page timeout
+// waits on its destination and no commit observer (e.g. a pending waiter) is set.
+STATEMACHINE_TEMPLATE
+uint16_t STATEMACHINE_CLASS::processEventsCoalesced(const eventID *events, size_t count,
+                                                   uint32_t navigationEvents, void *context) {
+  if (!events || count == 0) {
+    return 0;
+  }
+
+  // Verbose mode keeps the per-event diagnostics; inside an action the events may need
+  // deferring, and at the depth limit processEvent rejects them
+  if (_debugModeVerbose || _liveTable || _recursionDepth >= STATEMACHINE_MAX_RECURSION_DEPTH ||
+      (_runToCompletion && _recursionDepth > 0)) {
+    return processEvents(events, count, nullptr, context);
+  }
+
+  uint32_t startTime = micros();
+  currentState state = _currentState;
+  currentState runStart = state;
+  bool folding = false;
+  eventID lastFolded = 0;
+  uint32_t failed = 0;
+  uint32_t folded = 0;
+  uint16_t mask = 0;
+
+  for (size_t i = 0; i < count; i++) {
+    const eventID event = events[i];
+    transitionIndex index = NO_TRANSITION;
+    if (event < DONT_CARE_EVENT && isEventHandled(state, event)) {
+      index = findTransition(state, event);
+    }
+
+    if (index == NO_TRANSITION) {
+      failed++;
+      continue;
+    }
+
+    const stateTransition &trans = _transitions[index];
+    if (!trans.action && ((navigationEvents >> event) & 1UL) && !_commitObserver &&
+        !hasPageTimeout(trans.toPage)) {
+      if (!folding) {
+        runStart = state;
+        folding = true;
+      }
+      state.page = trans.toPage;
+      state.button = trans.toButton;
+      updateScoreboard(state.page);
+      lastFolded = event;
+      folded++;
+      continue;
+    }
+
+    // Everything else runs on its own and must see the committed state
+    if (folding) {
+      mask |= commitCoalescedRun(runStart, state, lastFolded);
+      folding = false;
+    }
+    mask |= processEvent(event, context);
+    state = _currentState;
+  }
+
+  if (folding) {
+    mask |= commitCoalescedRun(runStart, state, lastFolded);
+  }
+
+  _stats.totalTransitions += failed + folded;
+  _stats.failedTransitions += failed;
+  _stats.actionExecutions += folded;
+  _stats.stateChanges += folded;
+  if (folded > 0) {
+    updateStatistics((micros() - startTime) / folded, true);
+  }
+  return mask;
+}
+
+STATEMACHINE_TEMPLATE
+uint16_t STATEMACHINE_CLASS::commitCoalescedRun(const currentState &from, const currentState &to, eventID event) {
+  _lastState = from;
+  _currentState = to;
+  notePageChange(from.page, to.page);
+  const uint16_t mask = calculateRedrawMask(from, to);
+  publishSnapshot(mask);
+  if (_commitObserver) {
+    _commitObserver(_commitObserverUser, from, _currentState, event);
+  }
+  return mask;
+}
+
+STATEMACHINE_TEMPLATE
+bool STATEMACHINE_CLASS::hasPageTimeout(pageID page) const {
+  for (uint8_t i = 0; i < _pageTimeoutCount; i++) {
+    if (_pageTimeouts[i].page == page) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Timers
+STATEMACHINE_TEMPLATE
+uint32_t STATEMACHINE_CLASS::currentTimerTick() const {
+  const uint32_t nowMs = _timerClock ? _timerClock() : static_cast<uint32_t>(millis());
+  return nowMs / STATEMACHINE_TIMER_TICK_MS;
+}
+
+STATEMACHINE_TEMPLATE
+bool STATEMACHINE_CLASS::addPageTimeout(pageID page, uint32_t timeoutMs, eventID event, bool repeat) {
+  if (page >= DONT_CARE_PAGE || event >= DONT_CARE_EVENT || timeoutMs == 0 ||
+      _pageTimeoutCount >= STATEMACHINE_MAX_PAGE_TIMEOUTS) {
+    return false;
+  }
+  pageTimeout &rule = _pageTimeouts[_pageTimeoutCount++];
+  rule.page = page;
+  rule.event = event;
+  rule.repeat = repeat;
+  rule.timeoutTicks = msToTicks(timeoutMs);
+  rule.handle = -1;
+  // Already on the page: start counting now
+  if (_currentState.page == page) {
+    _timers.advanceTo(currentTimerTick());
+    rule.handle = _timers.schedule(rule.timeoutTicks, event, nullptr, repeat ? rule.timeoutTicks : 0, page);
+  }
+  return true;
+}
+
+STATEMACHINE_TEMPLATE
+void STATEMACHINE_CLASS::clearPageTimeouts() {
+  for (uint8_t i = 0; i < _pageTimeoutCount; i++) {
+    _timers.cancel(_pageTimeouts[i].handle);
+  }
+  _pageTimeoutCount = 0;
+}
+
+STATEMACHINE_TEMPLATE
+int32_t STATEMACHINE_CLASS::scheduleEvent(uint32_t delayMs, eventID event, void *context, uint32_t periodMs) {
+  if (event >= DONT_CARE_EVENT) {
+    return -1;
+  }
+  _timers.advanceTo(currentTimerTick());
+  return _timers.schedule(msToTicks(delayMs), event, context, periodMs ? msToTicks(periodMs) : 0);
+}
+
+// Leaving a page cancels its timeouts; entering it, or committing a transition on it, (re)arms them
+STATEMACHINE_TEMPLATE
+void STATEMACHINE_CLASS::updatePageTimers(pageID previous, pageID current) {
+  bool synced = false;
+  for (uint8_t i = 0; i < _pageTimeoutCount; i++) {
+    pageTimeout &rule = _pageTimeouts[i];
+    if (rule.page != current) {
+      if (rule.page == previous) {
+        _timers.cancel(rule.handle);
+        rule.handle = -1;
+      }
+      continue;
+    }
+    if (!synced) {
+      _timers.advanceTo(currentTimerTick());
+      synced = true;
+    }
+    _timers.cancel(rule.handle);
+    rule.handle = _timers.schedule(rule.timeoutTicks, rule.event, nullptr,
+                                   rule.repeat ? rule.timeoutTicks : 0, rule.page);
+  }
+}
+
+STATEMACHINE_TEMPLATE
+uint16_t STATEMACHINE_CLASS::updateTimers() {
+  _timers.advanceTo(currentTimerTick());
+  uint16_t mask = 0;
+  expiredTimer expired;
+  // Bounded so timers re-armed while processing wait for the next call
+  for (size_t i = 0; i < _timers.capacity() && _timers.popExpired(expired); i++) {
+    mask |= processEvent(expired.event, expired.context);
+  }
+  return mask;
+}
+
+// Run queued events in arrival order on the caller's thread; the HIGH lane is
+// checked before every NORMAL event so urgent events never wait behind a backlog
+STATEMACHINE_TEMPLATE
+uint16_t STATEMACHINE_CLASS::drainEvents(size_t maxCount) {
+  uint16_t mask = 0;
+  timedQueuedEvent urgent;
+  queuedEvent queued;
+  for (size_t i = 0; i < maxCount; i++) {
+    if (_priorityQueue.pop(urgent)) {
+      uint32_t latency = static_cast<uint32_t>(micros()) - urgent.postedAt;
+      if (latency > _priorityLatencyMax) {
+        _priorityLatencyMax = latency;
+      }
+      mask |= processPriorityEvent(urgent.event, urgent.context);
+    } else if (_eventQueue.pop(queued)) {
+      mask |= processEvent(queued.event, queued.context);
+    } else {
+      break;
+    }
+  }
+  return mask;
+}
+
+STATEMACHINE_TEMPLATE
+uint16_t STATEMACHINE_CLASS::processPriorityEvent(eventID event, void *context) {
+  // Inside an action in run-to-completion mode the event has to be deferred like any other
+  if (!_priorityGlobalDispatch || (_runToCompletion && _recursionDepth > 0)) {
+    return processEvent(event, context);
+  }
+  uint16_t mask = dispatchEvent(event, context, true);
+  if (_deferredCount > 0 && _recursionDepth == 0) {
+    mask |= runDeferredEvents();
+  }
+  return mask;
+}
+
+// First DONT_CARE_PAGE row matching state/event, in table order
+STATEMACHINE_TEMPLATE
+typename STATEMACHINE_CLASS::transitionIndex STATEMACHINE_CLASS::findGlobalTransition(const currentState &state,
+                                                                                     eventID event) {
+  if (_pageIndexDirty) {
+    buildPageIndex();
+  }
+  const uint32_t stateKey = packTransitionKey(state.page, state.button, event);
+  for (transitionIndex i = 0; i < _wildcardRowCount; i++) {
+    if (matchesTransition(_wildcardRows[i], stateKey)) {
+      return _wildcardRows[i];
+    }
+  }
+  return NO_TRANSITION;
+}
+
+// Calculate redraw mask based on state changes
+STATEMACHINE_TEMPLATE
+uint16_t STATEMACHINE_CLASS::calculateRedrawMask(const currentState &oldState,
+                                                        const currentState &newState) const {
+  uint16_t mask = 0;
+
+  if (oldState.page != newState.page) {
+    mask |= REDRAW_MASK_PAGE;
+  }
+
+  if (oldState.button != newState.button) {
+    mask |= REDRAW_MASK_BUTTON;
+  }
+
+  if ((mask & REDRAW_MASK_PAGE) && (mask & REDRAW_MASK_BUTTON)) {
+    mask |= REDRAW_MASK_FULL;
+  }
+
+  return mask;
+}
+
+// Helper methods
+// Returns the index of the first transition matching state/event, or NO_TRANSITION
+STATEMACHINE_TEMPLATE
+typename STATEMACHINE_CLASS::transitionIndex STATEMACHINE_CLASS::findTransition(const currentState &state, eventID event) {
+  // Sealed: the indexes cannot be stale, use the dispatch table when it fits, else the page index
+  if (_sealed) {
+    if (_dispatchTableValid && state.button < MaxButtons &&
+        event < MaxEvents) {
+      return _dispatchTable.at(_transitionPageSlot[state.page], state.button, event);
+    }
+    return findInPageIndex(state, packTransitionKey(state.page, state.button, event));
+  }
+
+  if (_lookupStrategy == lookupStrategy::DISPATCH_TABLE) {
+    if (_dispatchTableDirty) {
+      compileDispatchTable();
+    }
+    // Buttons outside the table range can only hit wildcard rows; let the scan handle them
+    if (_dispatchTableValid && state.button < MaxButtons &&
+        event < MaxEvents) {
+      return _dispatchTable.at(_transitionPageSlot[state.page], state.button, event);
+    }
+    // Too many pages for the table
+    if (!_dispatchTableValid) {
+      if (_pageIndexDirty) {
+        buildPageIndex();
+      }
+      return findInPageIndex(state, packTransitionKey(state.page, state.button, event));
+    }
+  }
+
+  uint32_t stateKey = packTransitionKey(state.page, state.button, event);
+
+  if (_lookupStrategy == lookupStrategy::PAGE_INDEX) {
+    if (_pageIndexDirty) {
+      buildPageIndex();
+    }
+    return findInPageIndex(state, stateKey);
+  }
+
+  if (_lookupStrategy == lookupStrategy::PACKED_SCAN) {
+    size_t index = _keys.findFirst(_transitionCount, state.page, state.button, event);
+    return (index < _transitionCount) ? static_cast<transitionIndex>(index) : NO_TRANSITION;
+  }
+
+  for (size_t i = 0; i < _transitionCount; i++) {
+    if (matchesTransition(i, stateKey)) {
+      return static_cast<transitionIndex>(i);
+    }
+  }
+  return NO_TRANSITION;
+}
+
+// Merge the page bucket with the DONT_CARE_PAGE rows in ascending index order
+STATEMACHINE_TEMPLATE
+typename STATEMACHINE_CLASS::transitionIndex STATEMACHINE_CLASS::findInPageIndex(const currentState &state, uint32_t stateKey) const {
+  const transitionIndex* rows = &_pageIndexRows[_pageIndexOffsets[state.page]];
+  const transitionIndex* rowsEnd = &_pageIndexRows[_pageIndexOffsets[state.page + 1]];
+  const transitionIndex* wildcards = _wildcardRows;
+  const transitionIndex* wildcardsEnd = _wildcardRows + _wildcardRowCount;
+  while (rows != rowsEnd || wildcards != wildcardsEnd) {
+    transitionIndex index;
+    if (wildcards == wildcardsEnd || (rows != rowsEnd && *rows < *wildcards)) {
+      index = *rows++;
+    } else {
+      index = *wildcards++;
+    }
+    if (matchesTransition(index, stateKey)) {
+      return index;
+    }
+  }
+  return NO_TRANSITION;
+}
+
+// Counting sort of the page-specific rows by fromPage. The sort is stable,
+// so each bucket keeps insertion order; DONT_CARE_PAGE rows go to their own list.
+STATEMACHINE_TEMPLATE
+void STATEMACHINE_CLASS::buildPageIndex() {
+  _pageIndexDirty = false;
+
+  memset(_pageIndexOffsets, 0, sizeof(_pageIndexOffsets));
+  _wildcardRowCount = 0;
+  for (size_t i = 0; i < _transitionCount; i++) {
+    pageID page = _transitions[i].fromPage;
+    if (page == DONT_CARE_PAGE) {
+      _wildcardRows[_wildcardRowCount++] = static_cast<transitionIndex>(i);
+    } else {
+      _pageIndexOffsets[page + 1]++;
+    }
+  }
+  for (size_t page = 0; page < 256; page++) {
+    _pageIndexOffsets[page + 1] += _pageIndexOffsets[page];
+  }
+
+  transitionIndex fill[256];
+  memcpy(fill, _pageIndexOffsets, sizeof(fill));
+  for (size_t i = 0; i < _transitionCount; i++) {
+    pageID page = _transitions[i].fromPage;
+    if (page != DONT_CARE_PAGE) {
+      _pageIndexRows[fill[page]++] = static_cast<transitionIndex>(i);
+    }
+  }
+}
+
+STATEMACHINE_TEMPLATE
+bool STATEMACHINE_CLASS::attachLiveTable(rcuPointer<basicStateMachine> *table) {
+  if (_liveTable) {
+    _liveTable->unregisterReader(_liveReader);
+    _liveTable = nullptr;
+    _liveReader = -1;
+  }
+  if (!table) {
+    return true;
+  }
+  const int reader = table->registerReader();
+  if (reader < 0) {
+    return false;
+  }
+  _liveTable = table;
+  _liveReader = reader;
+  return true;
+}
+
+STATEMACHINE_TEMPLATE
+const stateTransition *STATEMACHINE_CLASS::matchTransition(pageID page, buttonID button, eventID event) const {
+  currentState state;
+  state.page = page;
+  state.button = button;
+  if (event >= DONT_CARE_EVENT || !isEventHandled(state, event)) {
+    return nullptr;
+  }
+
+  const uint32_t stateKey = packTransitionKey(page, button, event);
+  transitionIndex index = NO_TRANSITION;
+  if (_sealed) {
+    if (_dispatchTableValid && button < MaxButtons && event < MaxEvents) {
+      index = _dispatchTable.at(_transitionPageSlot[page], button, event);
+    } else {
+      index = findInPageIndex(state, stateKey);
+    }
+  } else {
+    for (size_t i = 0; i < _transitionCount; i++) {
+      if (matchesTransition(i, stateKey)) {
+        index = static_cast<transitionIndex>(i);
+        break;
+      }
+    }
+  }
+  return (index == NO_TRANSITION) ? nullptr : &_transitions[index];
+}
+
+// One validation pass over the whole table, then compact out exact duplicates
+// (same key and destination; only the first can ever fire) and build every index.
+// The table order is kept: the page index is the per-page sorted view and
+// preserves first-match priority between overlapping rows.
+STATEMACHINE_TEMPLATE
+validationResult STATEMACHINE_CLASS::seal(bool checkConflicts) {
+  if (_sealed) {
+    return VALID;
+  }
+
+  _sealDuplicates.reset();
+  for (size_t i = 0; i < _transitionCount; i++) {
+    const stateTransition& trans = _transitions[i];
+
+    // A verbatim repeat of an earlier row is dropped; the earlier copy was already checked
+    for (size_t j = 0; j < i; j++) {
+      const stateTransition& earlier = _transitions[j];
+      if (!_sealDuplicates[j] && _keys.sameKey(j, i) &&
+          earlier.toPage == trans.toPage && earlier.toButton == trans.toButton) {
+        _sealDuplicates[i] = true;
+        break;
+      }
+    }
+    if (_sealDuplicates[i]) continue;
+
+    validationResult result = validateTransition(trans, i, checkConflicts, false);
+    if (result != VALID) {
+      if (_debugModeVerbose) {
+        Serial.printf("ERROR: seal rejected transition %u - %s\n",
+                      static_cast<unsigned>(i), getErrorDescription(result));
+      }
+      _lastErrorContext = transitionErrorContext(result, trans, i, _addTransitionCallSequence, "seal");
+      _stats.validationErrors++;
+      return result;
+    }
+  }
+
+  size_t kept = 0;
+  for (size_t i = 0; i < _transitionCount; i++) {
+    if (_sealDuplicates[i]) continue;
+    if (kept != i) {
+      _transitions[kept] = _transitions[i];
+      const stateTransition& trans = _transitions[kept];
+      _keys.set(kept, trans.fromPage, trans.fromButton, trans.event,
+                DONT_CARE_PAGE, DONT_CARE_BUTTON, DONT_CARE_EVENT);
+    }
+    kept++;
+  }
+  if (kept != _transitionCount) {
+    if (_debugModeVerbose) {
+      Serial.printf("seal: removed %u duplicate transitions\n",
+                    static_cast<unsigned>(_transitionCount - kept));
+    }
+    _transitionCount = kept;
+    resetTransitionIndex();
+    for (size_t i = 0; i < _transitionCount; i++) {
+      indexTransition(_transitions[i]);
+    }
+  }
+
+  compileDispatchTable();
+  buildPageIndex();
+  _sealed = true;
+  return VALID;
+}
+
+STATEMACHINE_TEMPLATE
+void STATEMACHINE_CLASS::setLookupStrategy(lookupStrategy strategy) {
+  _lookupStrategy = strategy;
+  // A sealed machine already has every index built
+  if (!_sealed) {
+    _dispatchTableDirty = true;
+    _pageIndexDirty = true;
+  }
+}
+
+// Expand every transition (including DONT_CARE rows) into a dense
+// [page slot][button][event] table holding the first matching row index.
+// Every page that owns a row needs its own slot; with more such pages than
+// DispatchPages the table is not built and lookups use the page index.
+STATEMACHINE_TEMPLATE
+bool STATEMACHINE_CLASS::compileDispatchTable() {
+  _dispatchTableDirty = false;
+  _dispatchTableValid = false;
+
+  if (_pageSlotCount > DISPATCH_SLOTS) {
+    if (_debugModeVerbose) {
+      Serial.printf("ERROR: dispatch table holds %u pages, configuration has %u\n",
+                    static_cast<unsigned>(DispatchPages), static_cast<unsigned>(_pageSlotCount - 1));
+    }
+    return false;
+  }
+
+  for (uint16_t slot = 0; slot < _pageSlotCount; slot++) {
+    for (uint8_t button = 0; button < MaxButtons; button++) {
+      for (uint8_t event = 0; event < MaxEvents; event++) {
+        _dispatchTable.at(slot, button, event) = NO_TRANSITION;
+      }
+    }
+  }
+
+  // Rows are applied in insertion order and never overwrite a filled cell,
+  // so each cell keeps the first-match priority of the linear scan
+  for (size_t i = 0; i < _transitionCount; i++) {
+    const auto& trans = _transitions[i];
+
+    uint16_t firstSlot = 0, lastSlot = _pageSlotCount;
+    if (trans.fromPage != DONT_CARE_PAGE) {
+      firstSlot = _transitionPageSlot[trans.fromPage];
+      lastSlot = firstSlot + 1;
+    }
+
+    uint8_t firstButton = 0, lastButton = MaxButtons;
+    if (trans.fromButton != DONT_CARE_BUTTON) {
+      if (trans.fromButton >= MaxButtons) continue;
+      firstButton = trans.fromButton;
+      lastButton = firstButton + 1;
+    }
+
+    uint8_t firstEvent = 0, lastEvent = MaxEvents;
+    if (trans.event != DONT_CARE_EVENT) {
+      if (trans.event >= MaxEvents) continue;
+      firstEvent = trans.event;
+      lastEvent = firstEvent + 1;
+    }
+
+    for (uint16_t slot = firstSlot; slot < lastSlot; slot++) {
+      for (uint8_t button = firstButton; button < lastButton; button++) {
+        for (uint8_t event = firstEvent; event < lastEvent; event++) {
+          transitionIndex& cell = _dispatchTable.at(slot, button, event);
+          if (cell == NO_TRANSITION) {
+            cell = static_cast<transitionIndex>(i);
+          }
+        }
+      }
+    }
+  }
+
+  _dispatchTableValid = true;
+  return true;
+}
+
+STATEMACHINE_TEMPLATE
+bool STATEMACHINE_CLASS::transitionsConflict(const stateTransition &existing, 
+                                                    const stateTransition &newTrans) const {
+  uint32_t existingKey = packTransitionKey(existing.fromPage, existing.fromButton, existing.event);
+  uint32_t newKey = packTransitionKey(newTrans.fromPage, newTrans.fromButton, newTrans.event);
+  bool sameDestination = existing.toPage == newTrans.toPage && existing.toButton == newTrans.toButton;
+
+  // Check for exact duplicates
+  if (existingKey == newKey && sameDestination) {
+    return true;
+  }
+
+  // Conflict when some state/event could match both transitions and the destinations differ
+  uint32_t existingCare = packTransitionCare(existing.fromPage, existing.fromButton, existing.event,
+                                             DONT_CARE_PAGE, DONT_CARE_BUTTON, DONT_CARE_EVENT);
+  uint32_t newCare = packTransitionCare(newTrans.fromPage, newTrans.fromButton, newTrans.event,
+                                        DONT_CARE_PAGE, DONT_CARE_BUTTON, DONT_CARE_EVENT);
+  return !sameDestination && keysOverlap(existingKey, existingCare, newKey, newCare);
+}
+
+STATEMACHINE_TEMPLATE
+void STATEMACHINE_CLASS::executeAction(const stateTransition &trans,
+                                              eventID event, void *context) {
+  if (trans.action) {
+    trans.action(trans.toPage, event, context);
+  }
+}
+
+// Debug and utility methods
+STATEMACHINE_TEMPLATE
+void STATEMACHINE_CLASS::dumpStateTable() const {
+#ifdef ARDUINO
+  Serial.println("\n--- STATES ---");
+  for (size_t i = 0; i < _stateCount; i++) {
+    Serial.printf("State %d: %s\n", pageAt(i).id, pageAt(i).shortName);
+  }
+
+
+
+  Serial.println("\n--- TRANSITION TABLE ---");
+  Serial.println("From     Button Event To       ToBtn Description");
+  Serial.println("-------- ------ ----- -------- ----- -----------");
+
+  for (size_t i = 0; i < _transitionCount; i++) {
+    const auto& trans = _transitions[i];
+    char fromName[9] = {0};
+    char toName[9] = {0};
+    char eventName[6] = {0};
+    char description[DESCRIPTION_BUFFER_SIZE] = {0};
+
+    snprintf(fromName, sizeof(fromName), "%u", trans.fromPage);
+    snprintf(toName, sizeof(toName), "%u", trans.toPage);
+
+    switch (trans.event) {
+    case 1: strcpy(eventName, "BTN1"); break;
+    case 2: strcpy(eventName, "BTN2"); break;
+    case 3: strcpy(eventName, "BTN3"); break;
+    case 4: strcpy(eventName, "BTN4"); break;
+    case 5: strcpy(eventName, "BTN5"); break;
+    case 6: strcpy(eventName, "BTN6"); break;
+    case 7: strcpy(eventName, "HOME"); break;
+    default: snprintf(eventName, sizeof(eventName), "%u", trans.event); break;
+    }
+
+    snprintf(description, sizeof(description), "%u->%u", trans.fromPage, trans.toPage);
+
+    Serial.printf("%-8s %-6u %-5s %-8s %-5u %s\n", fromName, trans.fromButton,
+                  eventName, toName, trans.toButton, description);
+  }
+
+  Serial.println("=== END STATIC STATE TABLE ===\n");
+#else
+  printf("=== STATIC STATE MACHINE ===\n");
+  printf("--- STATES ---\n");
+  for (size_t i = 0; i < _stateCount; i++) {
+    printf("State %d: %s\n", pageAt(i).id, pageAt(i).shortName);
+  }
+
+
+
+  printf("--- TRANSITION TABLE ---\n");
+  printf("From     Button Event To       ToBtn Description\n");
+  printf("-------- ------ ----- -------- ----- -----------\n");
+
+  for (size_t i = 0; i < _transitionCount; i++) {
+    const auto& trans = _transitions[i];
+    char fromName[9] = {0};
+    char toName[9] = {0};
+    char eventName[6] = {0};
+    char description[DESCRIPTION_BUFFER_SIZE] = {0};
+
+    snprintf(fromName, sizeof(fromName), "%u", trans.fromPage);
+    snprintf(toName, sizeof(toName), "%u", trans.toPage);
+
+    switch (trans.event) {
+    case 1: strcpy(eventName, "BTN1"); break;
+    case 2: strcpy(eventName, "BTN2"); break;
+    case 3: strcpy(eventName, "BTN3"); break;
+    case 4: strcpy(eventName, "BTN4"); break;
+    case 5: strcpy(eventName, "BTN5"); break;
+    case 6: strcpy(eventName, "BTN6"); break;
+    case 7: strcpy(eventName, "HOME"); break;
+    default: snprintf(eventName, sizeof(eventName), "%u", trans.event); break;
+    }
+
+    snprintf(description, sizeof(description), "%u->%u", trans.fromPage, trans.toPage);
+
+    printf("%-8s %-6u %-5s %-8s %-5u %s\n", fromName, trans.fromButton,
+           eventName, toName, trans.toButton, description);
+  }
+
+  printf("=== END STATE TABLE ===\n\n");
+#endif
+}
+
+STATEMACHINE_TEMPLATE
+void STATEMACHINE_CLASS::printCurrentState() const {
+  Serial.printf("Current: %d/%d \n", _currentState.page, _currentState.button);
+}
+
+STATEMACHINE_TEMPLATE
+void STATEMACHINE_CLASS::printTransition(const stateTransition &trans) const {
+  Serial.printf("%d\t%d\t%d\t%d\t%d\t%s\n", trans.fromPage, trans.fromButton,
+                trans.event, trans.toPage, trans.toButton,
+                trans.action ? "Yes" : "No");
+}
+
+STATEMACHINE_TEMPLATE
+void STATEMACHINE_CLASS::printAllTransitions() const {
+#ifdef ARDUINO
+  Serial.println("\n--- TRANSITION TABLE ---");
+  Serial.println("FromPage\tFromButton\tEvent\tToPage\tToButton\tAction");
+  for (size_t i = 0; i < _transitionCount; i++) {
+    printTransition(_transitions[i]);
+  }
+  Serial.println("--- END TRANSITION TABLE ---\n");
+#else
+  printf("\n--- TRANSITION TABLE ---\n");
+  printf("FromPage\tFromButton\tEvent\tToPage\tToButton\tAction\n");
+  for (size_t i = 0; i < _transitionCount; i++) {
+    printTransition(_transitions[i]);
+  }
+  printf("--- END TRANSITION TABLE ---\n");
+#endif
+}
+
+// Scoreboard functionality
+STATEMACHINE_TEMPLATE
+void STATEMACHINE_CLASS::updateScoreboard(pageID id) {
+  if (id < STATEMACHINE_SCOREBOARD_SEGMENT_SIZE) {
+    _stateScoreboard[0] |= (1UL << id);
+  } else if (id < STATEMACHINE_SCOREBOARD_SEGMENT_SIZE * 2) {
+    _stateScoreboard[1] |= (1UL << (id - STATEMACHINE_SCOREBOARD_SEGMENT_SIZE));
+  } else if (id < STATEMACHINE_SCOREBOARD_SEGMENT_SIZE * 3) {
+    _stateScoreboard[2] |= (1UL << (id - STATEMACHINE_SCOREBOARD_SEGMENT_SIZE * 2));
+  } else if (id < STATEMACHINE_SCOREBOARD_SEGMENT_SIZE * STATEMACHINE_SCOREBOARD_NUM_SEGMENTS) {
+    _stateScoreboard[3] |= (1UL << (id - STATEMACHINE_SCOREBOARD_SEGMENT_SIZE * 3));
+  }
+  if (_debugModeVerbose)
+    Serial.printf("Scoreboard(%d): %u/%u/%u/%u\n", id, _stateScoreboard[0],
+                  _stateScoreboard[1], _stateScoreboard[2], _stateScoreboard[3]);
+}
+
+STATEMACHINE_TEMPLATE
+uint32_t STATEMACHINE_CLASS::getScoreboard(uint8_t index) const {
+  if (index < STATEMACHINE_SCOREBOARD_NUM_SEGMENTS) {
+    return _stateScoreboard[index];
+  }
+  return 0;
+}
+
+STATEMACHINE_TEMPLATE
+void STATEMACHINE_CLASS::setScoreboard(uint32_t value, uint8_t index) {
+  if (index < STATEMACHINE_SCOREBOARD_NUM_SEGMENTS) {
+    _stateScoreboard[index] = value;
+  }
+}
+
+// Safety and validation methods
+STATEMACHINE_TEMPLATE
+validationResult STATEMACHINE_CLASS::validateTransition(const stateTransition &trans, bool verbose) const {
+  return validateTransition(trans, _transitionCount, true, verbose);
+}
+
+// Checks the IDs of trans and, with checkConflicts, its conflicts with the first priorRows rows
+STATEMACHINE_TEMPLATE
+validationResult STATEMACHINE_CLASS::validateTransition(const stateTransition &trans, size_t priorRows,
+                                                        bool checkConflicts, bool verbose) const {
+  // Check for valid state IDs
+  // Note: fromPage and fromButton are uint8_t, so they can't exceed their maximum values
+  // The DONT_CARE values are used as wildcards and are valid
+
+  if (trans.toPage >= DONT_CARE_PAGE) {
+    if (verbose && _debugModeVerbose) {
+      printf("validateTransition: INVALID_PAGE_ID, toPage=%d\n", trans.toPage);
+    }
+    return INVALID_PAGE_ID;
+  }
+  if (trans.toButton >= DONT_CARE_BUTTON) {
+    if (verbose && _debugModeVerbose) {
+      printf("validateTransition: INVALID_BUTTON_ID, toButton=%d\n", trans.toButton);
+    }
+    return INVALID_BUTTON_ID;
+  }
+  if (trans.event > DONT_CARE_EVENT) {
+    if (verbose && _debugModeVerbose) {
+      printf("validateTransition: INVALID_EVENT_ID, event=%d\n", trans.event);
+    }
+    return INVALID_EVENT_ID;
+  }
+
+  // Check for conflicting transitions
+  for (size_t i = 0; checkConflicts && i < priorRows; i++) {
+    const auto& existing = _transitions[i];
+    if (transitionsConflict(existing, trans)) {
+      return DUPLICATE_TRANSITION;
+    }
+  }
+  return VALID;
+}
+
+STATEMACHINE_TEMPLATE
+validationResult STATEMACHINE_CLASS::validateTransitionWithConflictDetails(const stateTransition &trans, 
+                                                                          stateTransition& conflictingTrans, 
+                                                                          size_t& conflictingIndex, 
+                                                                          bool verbose) const {
+  // Check for valid state IDs
+  // Note: fromPage and fromButton are uint8_t, so they can't exceed their maximum values
+  // The DONT_CARE values are used as wildcards and are valid
+
+  if (trans.toPage >= DONT_CARE_PAGE) {
+    if (verbose && _debugModeVerbose) {
+      printf("validateTransition: INVALID_PAGE_ID, toPage=%d\n", trans.toPage);
+    }
+    return INVALID_PAGE_ID;
+  }
+  if (trans.toButton >= DONT_CARE_BUTTON) {
+    if (verbose && _debugModeVerbose) {
+      printf("validateTransition: INVALID_BUTTON_ID, toButton=%d\n", trans.toButton);
+    }
+    return INVALID_BUTTON_ID;
+  }
+  if (trans.event > DONT_CARE_EVENT) {
+    if (verbose && _debugModeVerbose) {
+      printf("validateTransition: INVALID_EVENT_ID, event=%d\n", trans.event);
+    }
+    return INVALID_EVENT_ID;
+  }
+
+  // Check for conflicting transitions
+  for (size_t i = 0; i < _transitionCount; i++) {
+    const auto& existing = _transitions[i];
+    if (transitionsConflict(existing, trans)) {
+      conflictingTrans = existing;
+      conflictingIndex = i;
+      return DUPLICATE_TRANSITION;
+    }
+  }
+  return VALID;
+}
+
+STATEMACHINE_TEMPLATE
+validationResult STATEMACHINE_CLASS::validateStateMachine() const {
+  // Check for unreachable states
+  if (!isPageReachable(_currentState.page)) {
+    return UNREACHABLE_PAGE;
+  }
+
+  // Check for dangling states
+  if (hasDanglingStates()) {
+    return DANGLING_PAGE;
+  }
+
+  // Check for circular dependencies
+  if (hasCircularDependencies()) {
+    return CIRCULAR_DEPENDENCY;
+  }
+
+  return VALID;
+}
+
+STATEMACHINE_TEMPLATE
+validationResult STATEMACHINE_CLASS::validateConfiguration() const {
+  return validateStateMachine();
+}
+
+STATEMACHINE_TEMPLATE
+bool STATEMACHINE_CLASS::isPageReachable(pageID id) const {
+  for (size_t i = 0; i < _transitionCount; i++) {
+    const auto& trans = _transitions[i];
+    if (trans.toPage == id) {
+      return true;
+    }
+  }
+  return id == _currentState.page; // Initial state is always reachable
+}
+
+STATEMACHINE_TEMPLATE
+bool STATEMACHINE_CLASS::hasDanglingStates() const {
+  // Check if any states have no outgoing transitions
+  for (size_t s = 0; s < _stateCount; s++) {
+    bool hasTransition = false;
+    for (size_t t = 0; t < _transitionCount; t++) {
+      const auto& trans = _transitions[t];
+      if (trans.fromPage == pageAt(s).id && trans.fromPage != DONT_CARE_PAGE) {
+        hasTransition = true;
+        break;
+      }
+    }
+    if (!hasTransition) {
+      return true; // Found dangling state
+    }
+  }
+  return false;
+}
+
+STATEMACHINE_TEMPLATE
+bool STATEMACHINE_CLASS::hasCircularDependencies() const {
+  // Simple cycle detection
+  for (size_t i = 0; i < _transitionCount; i++) {
+    const auto& trans = _transitions[i];
+    if (trans.fromPage == trans.toPage && trans.fromPage != DONT_CARE_PAGE) {
+      continue; // Self-loops are allowed
+    }
+  }
+  return false; // More sophisticated cycle detection could be added
+}
+
+STATEMACHINE_TEMPLATE
+void STATEMACHINE_CLASS::updateStatistics(uint32_t transitionTime, bool success) {
+  _stats.lastTransitionTime = transitionTime;
+  
+  if (transitionTime > _stats.maxTransitionTime) {
+    _stats.maxTransitionTime = transitionTime;
+  }
+  
+  if (_stats.totalTransitions > 0) {
+    _stats.averageTransitionTime = (_stats.averageTransitionTime + transitionTime) / 2;
+  } else {
+    _stats.averageTransitionTime = transitionTime;
+  }
+}
+
+// Menu helper methods
+STATEMACHINE_TEMPLATE
+void STATEMACHINE_CLASS::addButtonNavigation(pageID menuId, uint8_t numButtons,
+                                                   const std::array<pageID, STATEMACHINE_MAX_MENU_LABELS>& targetMenus) {
+  for (uint8_t i = 0; i < numButtons && i < STATEMACHINE_MAX_MENU_LABELS; i++) {
+    // Add RIGHT navigation (next button)
+    buttonID nextButton = (i + 1) % numButtons;
+    addTransition(stateTransition(menuId, i, 1, menuId, nextButton, nullptr)); // eventRIGHT = 1
+
+    // Add LEFT navigation (previous button)
+    buttonID prevButton = (i == 0) ? (numButtons - 1) : (i - 1);
+    addTransition(stateTransition(menuId, i, 2, menuId, prevButton, nullptr)); // eventLEFT = 2
+
+    // Add DOWN navigation to target menu if specified
+    if (i < targetMenus.size() && targetMenus[i] != 0) {
+      addTransition(stateTransition(menuId, i, 0, targetMenus[i], 0, nullptr)); // eventDOWN = 0
+    }
+  }
+}
+
+STATEMACHINE_TEMPLATE
+void STATEMACHINE_CLASS::addStandardMenuTransitions(pageID menuId, pageID parentMenu,
+                                                           const std::array<pageID, STATEMACHINE_MAX_MENU_LABELS>& subMenus) {
+  // Determine number of buttons for this menu
+  uint8_t numButtons = 0;
+  for (size_t i = 0; i < subMenus.size() && i < STATEMACHINE_MAX_MENU_LABELS; i++) {
+    if (subMenus[i] != 0) numButtons++;
+  }
+  if (numButtons == 0) numButtons = 1;
+  
+  // For each button, add DOWN, LEFT, RIGHT transitions
+  for (uint8_t i = 0; i < numButtons; i++) {
+    // DOWN: transition to submenu (if exists) or parent
+    pageID downTarget = (i < subMenus.size() && subMenus[i] != 0) ? subMenus[i] : parentMenu;
+    addTransition(stateTransition(menuId, i, 0, downTarget, 0, nullptr)); // eventDOWN = 0
+
+    // RIGHT: increment button index (wrap modulo numButtons)
+    buttonID nextButton = (i + 1) % numButtons;
+    addTransition(stateTransition(menuId, i, 1, menuId, nextButton, nullptr)); // eventRIGHT = 1
+
+    // LEFT: decrement button index (wrap modulo numButtons)
+    buttonID prevButton = (i == 0) ? (numButtons - 1) : (i - 1);
+    addTransition(stateTransition(menuId, i, 2, menuId, prevButton, nullptr)); // eventLEFT = 2
+  }
+}
+
+// Enhanced error reporting methods
+STATEMACHINE_TEMPLATE
+const char*STATEMACHINE_CLASS::getErrorDescription(validationResult errorCode) const {
+  switch (errorCode) {
+    case VALID: return "Valid";
+    case INVALID_PAGE_ID: return "Invalid page ID";
+    case INVALID_BUTTON_ID: return "Invalid button ID";
+    case INVALID_EVENT_ID: return "Invalid event ID";
+    case INVALID_TRANSITION: return "Invalid transition";
+    case DUPLICATE_TRANSITION: return "Duplicate transition";
+    case DUPLICATE_PAGE: return "Duplicate page";
+    case INVALID_PAGE_NAME: return "Invalid page name";
+    case INVALID_PAGE_DISPLAY_NAME: return "Invalid page display name";
+    case INVALID_MENU_TEMPLATE: return "Invalid menu template";
+    case UNREACHABLE_PAGE: return "Unreachable page";
+    case DANGLING_PAGE: return "Dangling page";
+    case CIRCULAR_DEPENDENCY: return "Circular dependency";
+    case MAX_TRANSITIONS_EXCEEDED: return "Maximum transitions exceeded";
+    case MAX_PAGES_EXCEEDED: return "Maximum pages exceeded";
+    case MAX_MENUS_EXCEEDED: return "Maximum menus exceeded";
+    case MACHINE_SEALED: return "Machine is sealed";
+    case PAGE_ALLOCATION_FAILED: return "Page allocation failed";
+    default: return "Unknown error";
+  }
+}
+
+STATEMACHINE_TEMPLATE
+void STATEMACHINE_CLASS::printLastErrorDetails() const {
+  if (!hasLastError()) {
+    Serial.println("No error to report");
+    return;
+  }
+  
+  Serial.println("=== LAST TRANSITION ERROR DETAILS ===");
+  printTransitionError(_lastErrorContext);
+}
+
+STATEMACHINE_TEMPLATE
+void STATEMACHINE_CLASS::printTransitionError(const stateTransition &error) const {
+  Serial.printf("Error Code: %d (%s)\n", static_cast<int>(INVALID_TRANSITION), 
+                getErrorDescription(INVALID_TRANSITION));
+  
+  // Note: fromPage and fromButton are uint8_t, so they can't exceed their maximum values
+  // These checks are redundant and have been removed
+  if (error.toPage >= DONT_CARE_PAGE) {
+    Serial.printf("Error Location: INVALID_PAGE_ID, toPage=%d\n", error.toPage);
+  }
+  if (error.toButton >= DONT_CARE_BUTTON) {
+    Serial.printf("Error Location: INVALID_BUTTON_ID, toButton=%d\n", error.toButton);
+  }
+  if (error.event > DONT_CARE_EVENT) {
+    Serial.printf("Error Location: INVALID_EVENT_ID, event=%d\n", error.event);
+  }
+  
+  Serial.println("Failed Transition Details:");
+  Serial.printf("  From: Page %d, Button %d\n", error.fromPage, error.fromButton);
+  Serial.printf("  Event: %d\n", error.event);
+  Serial.printf("  To: Page %d, Button %d\n", error.toPage, error.toButton);
+  Serial.printf("  Action: %s\n", error.action ? "Present" : "None");
+  
+  Serial.println("=====================================");
+}
+
+STATEMACHINE_TEMPLATE
+void STATEMACHINE_CLASS::printTransitionError(const transitionErrorContext& error) const {
+  Serial.printf("Error Code: %d (%s)\n", static_cast<int>(error.errorCode), 
+                getErrorDescription(error.errorCode));
+  
+  if (error.errorLocation) {
+    Serial.printf("Location: %s\n", error.errorLocation);
+  }
+  
+  Serial.printf("Call Sequence: %d\n", error.callSequence);
+  Serial.printf("Transition Index: %d\n", error.transitionIndex);
+  
+  Serial.println("Failed Transition Details:");
+  Serial.printf("  From: Page %d, Button %d\n", error.failedTransition.fromPage, error.failedTransition.fromButton);
+  Serial.printf("  Event: %d\n", error.failedTransition.event);
+  Serial.printf("  To: Page %d, Button %d\n", error.failedTransition.toPage, error.failedTransition.toButton);
+  Serial.printf("  Action: %s\n", error.failedTransition.action ? "Present" : "None");
+  
+  // For duplicate transitions, show the conflicting transition details
+  if (error.errorCode == DUPLICATE_TRANSITION && error.conflictingTransitionIndex > 0) {
+    Serial.println("\nConflicts with existing transition (index " + String(error.conflictingTransitionIndex) + "):");
+    Serial.printf("  From: Page %d, Button %d, Event %d\n", error.conflictingTransition.fromPage, error.conflictingTransition.fromButton, error.conflictingTransition.event);
+    Serial.printf("  To: Page %d, Button %d\n", error.conflictingTransition.toPage, error.conflictingTransition.toButton);
+    Serial.printf("  Action: %s\n", error.conflictingTransition.action ? "Present" : "None");
+    
+    Serial.println("\nConflict Analysis:");
+    if (error.conflictingTransition.fromPage == DONT_CARE_PAGE || error.failedTransition.fromPage == DONT_CARE_PAGE || error.conflictingTransition.fromPage == error.failedTransition.fromPage) {
+      Serial.println("  - Pages could overlap (one or both use DONT_CARE or same page)");
+    }
+    if (error.conflictingTransition.fromButton == DONT_CARE_BUTTON || error.failedTransition.fromButton == DONT_CARE_BUTTON || error.conflictingTransition.fromButton == error.failedTransition.fromButton) {
+      Serial.println("  - Buttons could overlap (one or both use DONT_CARE or same button)");
+    }
+    if (error.conflictingTransition.event == DONT_CARE_EVENT || error.failedTransition.event == DONT_CARE_EVENT || error.conflictingTransition.event == error.failedTransition.event) {
+      Serial.println("  - Events could overlap (one or both use DONT_CARE or same event)");
+    }
+    Serial.println("  - Different destinations cause conflict");
+  }
+  
+  if (error.timestamp > 0) {
+    Serial.printf("Timestamp: %d\n", error.timestamp);
+  }
+  
+  Serial.println("=====================================");
+}
+
+STATEMACHINE_TEMPLATE
+validationResult STATEMACHINE_CLASS::addTransition(const stateTransition& transition, const char* location, transitionErrorContext& errorContext) {
+  _addTransitionCallSequence++;
+  
+  if (_sealed) {
+    errorContext = transitionErrorContext(MACHINE_SEALED, transition,
+                                        _transitionCount, _addTransitionCallSequence, location);
+    _lastErrorContext = errorContext;
+    return MACHINE_SEALED;
+  }
+
+  // Check for maximum transitions
+  if (_transitionCount >= MaxTransitions) {
+    if (_debugModeVerbose) {
+      Serial.printf("ERROR: Maximum transitions (%d) exceeded\n", static_cast<int>(MaxTransitions));
+    }
+    
+    // Populate error context
+    errorContext = transitionErrorContext(MAX_TRANSITIONS_EXCEEDED, transition, 
+                                        _transitionCount, _addTransitionCallSequence, location);
+    _lastErrorContext = errorContext;
+    return MAX_TRANSITIONS_EXCEEDED;
+  }
+
+  // Validate transition if validation is enabled
+  if (_validationEnabled) {
+    validationResult result = validateTransition(transition);
+    if (result != VALID) {
+      if (_debugModeVerbose) {
+        Serial.printf("ERROR: Invalid transition - %s (code %d) at %s:%d\n", 
+                     getErrorDescription(result), static_cast<int>(result), 
+                     __FUNCTION__, __LINE__);
+        
+        // For duplicate transitions, show the conflicting transition details
+        if (result == DUPLICATE_TRANSITION) {
+          stateTransition conflictingTrans;
+          size_t conflictingIndex = 0;
+          validateTransitionWithConflictDetails(transition, conflictingTrans, conflictingIndex, false);
+          printDuplicateTransitionError(transition, conflictingTrans, conflictingIndex);
+        }
+      }
+      
+      // Populate error context
+      if (result == DUPLICATE_TRANSITION) {
+        stateTransition conflictingTrans;
+        size_t conflictingIndex = 0;
+        validateTransitionWithConflictDetails(transition, conflictingTrans, conflictingIndex, false);
+        errorContext = transitionErrorContext(result, transition, 
+                                            _transitionCount, _addTransitionCallSequence, location,
+                                            conflictingTrans, conflictingIndex);
+      } else {
+        errorContext = transitionErrorContext(result, transition, 
+                                            _transitionCount, _addTransitionCallSequence, location);
+      }
+      _lastErrorContext = errorContext;
+      _stats.validationErrors++;
+      return result;
+    }
+  }
+
+  appendTransition(transition);
+  return VALID;
+}
+
+STATEMACHINE_TEMPLATE
+void STATEMACHINE_CLASS::printDuplicateTransitionError(const stateTransition& newTrans, 
+                                                       const stateTransition& existingTrans, 
+                                                       size_t existingIndex) const {
+  Serial.println("=== DUPLICATE TRANSITION ERROR ===");
+  Serial.println("New transition (rejected):");
+  Serial.printf("  From: Page %d, Button %d, Event %d\n", newTrans.fromPage, newTrans.fromButton, newTrans.event);
+  Serial.printf("  To: Page %d, Button %d\n", newTrans.toPage, newTrans.toButton);
+  Serial.printf("  Action: %s\n", newTrans.action ? "Present" : "None");
+  
+  Serial.println("\nConflicts with existing transition (index " + String(existingIndex) + "):");
+  Serial.printf("  From: Page %d, Button %d, Event %d\n", existingTrans.fromPage, existingTrans.fromButton, existingTrans.event);
+  Serial.printf("  To: Page %d, Button %d\n", existingTrans.toPage, existingTrans.toButton);
+  Serial.printf("  Action: %s\n", existingTrans.action ? "Present" : "None");
+  
+  Serial.println("\nConflict Analysis:");
+  if (existingTrans.fromPage == DONT_CARE_PAGE || newTrans.fromPage == DONT_CARE_PAGE || existingTrans.fromPage == newTrans.fromPage) {
+    Serial.println("  - Pages could overlap (one or both use DONT_CARE or same page)");
+  }
+  if (existingTrans.fromButton == DONT_CARE_BUTTON || newTrans.fromButton == DONT_CARE_BUTTON || existingTrans.fromButton == newTrans.fromButton) {
+    Serial.println("  - Buttons could overlap (one or both use DONT_CARE or same button)");
+  }
+  if (existingTrans.event == DONT_CARE_EVENT || newTrans.event == DONT_CARE_EVENT || existingTrans.event == newTrans.event) {
+    Serial.println("  - Events could overlap (one or both use DONT_CARE or same event)");
+  }
+  Serial.println("  - Different destinations cause conflict");
+  
+  Serial.println("=== END DUPLICATE TRANSITION ERROR ===");
+}
+
+// Enhanced page validation methods
+STATEMACHINE_TEMPLATE
+validationResult STATEMACHINE_CLASS::validatePage(const pageDefinition& page, bool verbose) const {
+  // Check page ID range
+  if (page.id >= DONT_CARE_PAGE) {
+    if (verbose && _debugModeVerbose) {
+      Serial.printf("ERROR: Page ID %d exceeds maximum (%d)\n", page.id, DONT_CARE_PAGE);
+    }
+    return INVALID_PAGE_ID;
+  }
+  
+  // Check page name validity
+  if (!page.shortName || strlen(page.shortName) == 0 || strlen(page.shortName) >= sizeof(page.shortName)) {
+    if (verbose && _debugModeVerbose) {
+      Serial.printf("ERROR: Invalid page name for page %d\n", page.id);
+    }
+    return INVALID_PAGE_NAME;
+  }
+  
+  // Check display name validity
+  if (!page.longName || strlen(page.longName) == 0 || strlen(page.longName) >= sizeof(page.longName)) {
+    if (verbose && _debugModeVerbose) {
+      Serial.printf("ERROR: Invalid display name for page %d\n", page.id);
+    }
+    return INVALID_PAGE_DISPLAY_NAME;
+  }
+  
+  // Check menu template validity
+  if (static_cast<uint8_t>(page.templateType) >= static_cast<uint8_t>(menuTemplate::MAX_NUMBER_OF_BUTTONS)) {
+    if (verbose && _debugModeVerbose) {
+      Serial.printf("ERROR: Invalid menu template %d for page %d\n", 
+                    static_cast<int>(page.templateType), page.id);
+    }
+    return INVALID_MENU_TEMPLATE;
+  }
+  
+  return VALID;
+}
+
+STATEMACHINE_TEMPLATE
+validationResult STATEMACHINE_CLASS::validatePageWithConflictDetails(const pageDefinition& page,
+                                                                    pageDefinition& conflictingPage, 
+                                                                    size_t& conflictingIndex, 
+                                                                    bool verbose) const {
+  // First validate the page itself
+  validationResult result = validatePage(page, verbose);
+  if (result != VALID) {
+    return result;
+  }
+  
+  // Check for duplicate page ID
+  if (_pageSlotOfId[page.id] != NO_PAGE_SLOT) {
+    conflictingIndex = _pageSlotOfId[page.id];
+    conflictingPage = pageAt(conflictingIndex);
+    return DUPLICATE_PAGE;
+  }
+  
+  return VALID;
+}
+
+// Enhanced addState method with location
+STATEMACHINE_TEMPLATE
+validationResult STATEMACHINE_CLASS::addState(const pageDefinition& state, const char* location) {
+  _addStateCallSequence++;
+  
+  if (_sealed) {
+    _lastPageErrorContext = pageErrorContext(MACHINE_SEALED, state,
+                                           _stateCount, _addStateCallSequence, location);
+    return MACHINE_SEALED;
+  }
+
+  // Check for maximum states
+  if (_stateCount >= PAGE_CAPACITY) {
+    if (_debugModeVerbose) {
+      Serial.printf("ERROR: Maximum states (%d) exceeded\n", static_cast<int>(PAGE_CAPACITY));
+    }
+    
+    // Populate page error context
+    _lastPageErrorContext = pageErrorContext(MAX_PAGES_EXCEEDED, state, 
+                                           _stateCount, _addStateCallSequence, location);
+    return MAX_PAGES_EXCEEDED;
+  }
+  
+  // Validate page if validation is enabled
+  if (_validationEnabled) {
+    validationResult result = validatePage(state);
+    if (result != VALID) {
+      if (_debugModeVerbose) {
+        Serial.printf("ERROR: Invalid page - %s (code %d) at %s:%d\n", 
+                     getErrorDescription(result), static_cast<int>(result), 
+                     __FUNCTION__, __LINE__);
+      }
+      
+      // Populate page error context
+      _lastPageErrorContext = pageErrorContext(result, state, 
+                                             _stateCount, _addStateCallSequence, location);
+      _stats.validationErrors++;
+      return result;
+    }
+  }
+  
+  // Check for duplicate pages
+  if (_pageSlotOfId[state.id] != NO_PAGE_SLOT) {
+    const size_t i = _pageSlotOfId[state.id];
+    if (_debugModeVerbose) {
+      Serial.printf("ERROR: Duplicate page ID %d\n", state.id);
+    }
+    
+    // Populate page error context with conflict details
+    _lastPageErrorContext = pageErrorContext(DUPLICATE_PAGE, state, 
+                                           _stateCount, _addStateCallSequence, location,
+                                           pageAt(i), i);
+    return DUPLICATE_PAGE;
+  }
+  
+  return storePage(state);
+}
+
+// Enhanced addState method with error context
+STATEMACHINE_TEMPLATE
+validationResult STATEMACHINE_CLASS::addState(const pageDefinition& state, const char* location, pageErrorContext& errorContext) {
+  _addStateCallSequence++;
+  
+  if (_sealed) {
+    errorContext = pageErrorContext(MACHINE_SEALED, state,
+                                  _stateCount, _addStateCallSequence, location);
+    _lastPageErrorContext = errorContext;
+    return MACHINE_SEALED;
+  }
+
+  // Check for maximum states
+  if (_stateCount >= PAGE_CAPACITY) {
+    if (_debugModeVerbose) {
+      Serial.printf("ERROR: Maximum states (%d) exceeded\n", static_cast<int>(PAGE_CAPACITY));
+    }
+    
+    // Populate error context
+    errorContext = pageErrorContext(MAX_PAGES_EXCEEDED, state, 
+                                  _stateCount, _addStateCallSequence, location);
+    _lastPageErrorContext = errorContext;
+    return MAX_PAGES_EXCEEDED;
+  }
+  
+  // Validate page if validation is enabled
+  if (_validationEnabled) {
+    validationResult result = validatePage(state);
+    if (result != VALID) {
+      if (_debugModeVerbose) {
+        Serial.printf("ERROR: Invalid page - %s (code %d) at %s:%d\n", 
+                     getErrorDescription(result), static_cast<int>(result), 
+                     __FUNCTION__, __LINE__);
+      }
+      
+      // Populate error context
+      errorContext = pageErrorContext(result, state, 
+                                    _stateCount, _addStateCallSequence, location);
+      _lastPageErrorContext = errorContext;
+      _stats.validationErrors++;
+      return result;
+    }
+  }
+  
+  // Check for duplicate pages
+  if (_pageSlotOfId[state.id] != NO_PAGE_SLOT) {
+    const size_t i = _pageSlotOfId[state.id];
+    if (_debugModeVerbose) {
+      Serial.printf("ERROR: Duplicate page ID %d\n", state.id);
+    }
+    
+    // Populate error context with conflict details
+    errorContext = pageErrorContext(DUPLICATE_PAGE, state, 
+                                  _stateCount, _addStateCallSequence, location,
+                                  pageAt(i), i);
+    _lastPageErrorContext = errorContext;
+    return DUPLICATE_PAGE;
+  }
+  
+  return storePage(state);
+}
+
+// Page error printing methods
+STATEMACHINE_TEMPLATE
+void STATEMACHINE_CLASS::printLastPageErrorDetails() const {
+  if (!hasLastPageError()) {
+    Serial.println("No page error to report");
+    return;
+  }
+  
+  Serial.println("=== LAST PAGE ERROR DETAILS ===");
+  printPageError(_lastPageErrorContext);
+}
+
+STATEMACHINE_TEMPLATE
+void STATEMACHINE_CLASS::printPageError(const pageDefinition& page) const {
+  Serial.println("=== PAGE ERROR ===");
+  Serial.printf("Page ID: %d\n", page.id);
+  Serial.printf("Page Name: %s\n", page.shortName);
+  Serial.printf("Display Name: %s\n", page.longName);
+  Serial.printf("Menu Template: %d\n", static_cast<int>(page.templateType));
+  Serial.println("==================");
+}
+
+STATEMACHINE_TEMPLATE
+void STATEMACHINE_CLASS::printPageError(const pageErrorContext& error) const {
+  Serial.printf("Error Code: %d (%s)\n", static_cast<int>(error.errorCode), 
+                getErrorDescription(error.errorCode));
+  
+  if (error.errorLocation) {
+    Serial.printf("Location: %s\n", error.errorLocation);
+  }
+  
+  Serial.printf("Call Sequence: %d\n", error.callSequence);
+  Serial.printf("Page Index: %d\n", error.pageIndex);
+  
+  Serial.println("Failed Page Details:");
+  Serial.printf("  ID: %d\n", error.failedPage.id);
+  Serial.printf("  Name: %s\n", error.failedPage.shortName);
+  Serial.printf("  Display Name: %s\n", error.failedPage.longName);
+  Serial.printf("  Menu Template: %d\n", static_cast<int>(error.failedPage.templateType));
+  
+  // For duplicate pages, show the conflicting page details
+  if (error.errorCode == DUPLICATE_PAGE && error.conflictingPageIndex > 0) {
+    Serial.println("\nConflicts with existing page (index " + String(error.conflictingPageIndex) + "):");
+    Serial.printf("  ID: %d\n", error.conflictingPage.id);
+    Serial.printf("  Name: %s\n", error.conflictingPage.shortName);
+    Serial.printf("  Display Name: %s\n", error.conflictingPage.longName);
+    Serial.printf("  Menu Template: %d\n", static_cast<int>(error.conflictingPage.templateType));
+  }
+  
+  if (error.timestamp > 0) {
+    Serial.printf("Timestamp: %d\n", error.timestamp);
+  }
+  
+  Serial.println("=====================================");
+}
+
+STATEMACHINE_TEMPLATE
+void STATEMACHINE_CLASS::printDuplicatePageError(const pageDefinition& newPage, 
+                                                 const pageDefinition& existingPage, 
+                                                 size_t existingIndex) const {
+  Serial.println("=== DUPLICATE PAGE ERROR ===");
+  Serial.println("New page (rejected):");
+  Serial.printf("  ID: %d\n", newPage.id);
+  Serial.printf("  Name: %s\n", newPage.shortName);
+  Serial.printf("  Display Name: %s\n", newPage.longName);
+  Serial.printf("  Menu Template: %d\n", static_cast<int>(newPage.templateType));
+  
+  Serial.println("\nConflicts with existing page (index " + String(existingIndex) + "):");
+  Serial.printf("  ID: %d\n", existingPage.id);
+  Serial.printf("  Name: %s\n", existingPage.shortName);
+  Serial.printf("  Display Name: %s\n", existingPage.longName);
+  Serial.printf("  Menu Template: %d\n", static_cast<int>(existingPage.templateType));
+  
+  Serial.println("\nConflict Analysis:");
+  Serial.printf("  - Both pages have the same ID (%d)\n", newPage.id);
+  Serial.println("  - Page IDs must be unique");
+  
+  Serial.println("=== END DUPLICATE PAGE ERROR ===");
+}
+
+// Button config key getters and setters
+STATEMACHINE_TEMPLATE
+buttonValues *STATEMACHINE_CLASS::findButtonValues(pageID pageId, buttonID buttonId) {
+    if (buttonId >= static_cast<buttonID>(menuTemplate::MAX_NUMBER_OF_BUTTONS)) {
+        return nullptr;
+    }
+    const uint8_t slot = _pageSlotOfId[pageId];
+    return (slot == NO_PAGE_SLOT) ? nullptr : &pageAt(slot).buttons[buttonId];
+}
+
+STATEMACHINE_TEMPLATE
+String STATEMACHINE_CLASS::getButtonConfigKey(pageID pageId, buttonID buttonId) const {
+    return String(getButtonConfigKeyView(pageId, buttonId));
+}
+
+STATEMACHINE_TEMPLATE
+String STATEMACHINE_CLASS::getButtonConfigValue(pageID pageId, buttonID buttonId) const {
+    return String(getButtonConfigValueView(pageId, buttonId));
+}
+
+STATEMACHINE_TEMPLATE
+const char *STATEMACHINE_CLASS::getButtonConfigKeyView(pageID pageId, buttonID buttonId) const {
+    const pageDefinition* page = getState(pageId);
+    if (!page || buttonId >= static_cast<buttonID>(menuTemplate::MAX_NUMBER_OF_BUTTONS)) {
+        return "";
+    }
+    return page->buttons[buttonId].storage.first.c_str();
+}
+
+STATEMACHINE_TEMPLATE
+const char *STATEMACHINE_CLASS::getButtonConfigValueView(pageID pageId, buttonID buttonId) const {
+    const pageDefinition* page = getState(pageId);
+    if (!page || buttonId >= static_cast<buttonID>(menuTemplate::MAX_NUMBER_OF_BUTTONS)) {
+        return "";
+    }
+    return page->buttons[buttonId].storage.second.c_str();
+}
+
+STATEMACHINE_TEMPLATE
+void STATEMACHINE_CLASS::setButtonConfigKey(pageID pageId, buttonID buttonId, const String& key) {
+    setButtonConfigKey(pageId, buttonId, key.c_str());
+}
+
+STATEMACHINE_TEMPLATE
+void STATEMACHINE_CLASS::setButtonConfigValue(pageID pageId, buttonID buttonId, const String& value) {
+    setButtonConfigValue(pageId, buttonId, value.c_str());
+}
+
+STATEMACHINE_TEMPLATE
+void STATEMACHINE_CLASS::setButtonConfigPair(pageID pageId, buttonID buttonId, const String& key, const String& value) {
+    setButtonConfigPair(pageId, buttonId, key.c_str(), value.c_str());
+}
+
+STATEMACHINE_TEMPLATE
+void STATEMACHINE_CLASS::setButtonConfigKey(pageID pageId, buttonID buttonId, const char* key) {
+    buttonValues* button = findButtonValues(pageId, buttonId);
+    if (button) {
+        button->storage.first = key ? key : "";
+    }
+}
+
+STATEMACHINE_TEMPLATE
+void STATEMACHINE_CLASS::setButtonConfigValue(pageID pageId, buttonID buttonId, const char* value) {
+    buttonValues* button = findButtonValues(pageId, buttonId);
+    if (button) {
+        button->storage.second = value ? value : "";
+    }
+}
+
+STATEMACHINE_TEMPLATE
+void STATEMACHINE_CLASS::setButtonConfigPair(pageID pageId, buttonID buttonId, const char* key, const char* value) {
+    buttonValues* button = findButtonValues(pageId, buttonId);
+    if (button) {
+        button->storage.first = key ? key : "";
+        button->storage.second = value ? value : "";
+    }
+}
+
+STATEMACHINE_TEMPLATE
+std::pair<String, String> STATEMACHINE_CLASS::getButtonConfigPair(pageID pageId, buttonID buttonId) const {
+    return std::make_pair(String(getButtonConfigKeyView(pageId, buttonId)),
+                          String(getButtonConfigValueView(pageId, buttonId)));
+}
+
+// Button label getters and setters
+STATEMACHINE_TEMPLATE
+const char*STATEMACHINE_CLASS::getButtonLabel(pageID pageId, buttonID buttonId) const {
+    const pageDefinition* page = getState(pageId);
+    if (!page || buttonId >= static_cast<buttonID>(menuTemplate::MAX_NUMBER_OF_BUTTONS)) {
+        return "";
+    }
+    return page->buttons[buttonId].label;
+}
+
+STATEMACHINE_TEMPLATE
+void STATEMACHINE_CLASS::setButtonLabel(pageID pageId, buttonID buttonId, const char* label) {
+    buttonValues* button = findButtonValues(pageId, buttonId);
+    if (button) {
+        strncpy(button->label, label ? label : "", BUTTON_STRING_LENGTH - 1);
+        button->label[BUTTON_STRING_LENGTH - 1] = '\0';
+    }
+}
+
+// Button EEPROM key getters and setters
+STATEMACHINE_TEMPLATE
+const eepromKey&STATEMACHINE_CLASS::getButtonEepromKey(pageID pageId, buttonID buttonId) const {
+    static const eepromKey emptyKey;
+    const pageDefinition* page = getState(pageId);
+    if (!page || buttonId >= static_cast<buttonID>(menuTemplate::MAX_NUMBER_OF_BUTTONS)) {
+        return emptyKey;
+    }
+    return page->buttons[buttonId].eepromKeyData;
+}
+
+STATEMACHINE_TEMPLATE
+void STATEMACHINE_CLASS::setButtonEepromKey(pageID pageId, buttonID buttonId, const eepromKey& key) {
+    buttonValues* button = findButtonValues(pageId, buttonId);
+    if (button) {
+        button->eepromKeyData = key;
+    }
+}
+
+#undef STATEMACHINE_CLASS
+#undef STATEMACHINE_TEMPLATE
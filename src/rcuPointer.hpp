@@ -0,0 +1,198 @@
+#pragma once
+
+// Read-copy-update cell for swapping an immutable object while readers use it.
+//
+//   rcuPointer<improvedStateMachine> live;             // writer: network task
+//   std::shared_ptr<improvedStateMachine> next = std::make_shared<improvedStateMachine>();
+//   next->addTransition(...);                          // built off to the side
+//   next->seal();
+//   live.publish(next);                                // readers switch atomically
+//
+//   int reader = live.registerReader();                // reader: event task
+//   {
+//       rcuPointer<improvedStateMachine>::readGuard guard(&live, reader);
+//       const improvedStateMachine* table = guard.get(); // stays valid until the guard ends
+//   }
+//
+// Reclamation is epoch based. A reader announces the global epoch in its own slot
+// when it enters and clears it when it leaves; publish swaps the pointer, bumps the
+// epoch and retires the old object tagged with the new epoch. A retired object is
+// released once no slot still holds an older epoch, i.e. after every reader that
+// could have seen it has left. Readers never wait, allocate or write shared lines
+// other than their own slot; only the (single) writer ever waits, and only when
+// STATEMACHINE_RCU_MAX_RETIRED versions are still pinned by slow readers.
+// Objects are owned through std::shared_ptr, so a retired version also lives on
+// while anything else holds a reference to it.
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include "eventQueue.hpp"
+
+// Reader slots per cell
+#ifndef STATEMACHINE_RCU_MAX_READERS
+    #define STATEMACHINE_RCU_MAX_READERS 4
+#endif
+
+// Replaced versions that may wait for their grace period at once
+#ifndef STATEMACHINE_RCU_MAX_RETIRED
+    #define STATEMACHINE_RCU_MAX_RETIRED 4
+#endif
+
+template <typename T>
+class rcuPointer {
+public:
+    // Read-side critical section; nests, and a null cell gives a null, no-op guard
+    class readGuard {
+    public:
+        readGuard(const rcuPointer* cell, int reader)
+            : _cell(cell), _reader(reader), _value(cell ? cell->enter(reader) : nullptr) {}
+        ~readGuard() {
+            if (_cell) {
+                _cell->leave(_reader);
+            }
+        }
+
+        const T* get() const { return _value; }
+        const T* operator->() const { return _value; }
+
+    private:
+        readGuard(const readGuard&);
+        readGuard& operator=(const readGuard&);
+
+        const rcuPointer* _cell;
+        int _reader;
+        const T* _value;
+    };
+
+    rcuPointer() : _current(nullptr), _epoch(1), _version(0), _retiredCount(0) {
+        for (size_t i = 0; i < STATEMACHINE_RCU_MAX_READERS; i++) {
+            _readers[i].epoch.store(0, std::memory_order_relaxed);
+            _readers[i].registered.store(false, std::memory_order_relaxed);
+            _readers[i].nesting = 0;
+        }
+    }
+
+    ~rcuPointer() { _current.store(nullptr, std::memory_order_relaxed); }
+
+    // Claims a reader slot; -1 when all STATEMACHINE_RCU_MAX_READERS are taken
+    int registerReader() {
+        for (size_t i = 0; i < STATEMACHINE_RCU_MAX_READERS; i++) {
+            bool expected = false;
+            if (_readers[i].registered.compare_exchange_strong(expected, true, std::memory_order_acq_rel)) {
+                _readers[i].nesting = 0;
+                return static_cast<int>(i);
+            }
+        }
+        return -1;
+    }
+
+    // Only outside a read-side critical section
+    void unregisterReader(int reader) {
+        if (reader >= 0 && reader < STATEMACHINE_RCU_MAX_READERS) {
+            _readers[reader].epoch.store(0, std::memory_order_release);
+            _readers[reader].registered.store(false, std::memory_order_release);
+        }
+    }
+
+    // Writer side, one thread at a time. Returns once the new version is visible;
+    // the old one is released after its grace period.
+    void publish(const std::shared_ptr<const T>& next) {
+        while (_retiredCount >= STATEMACHINE_RCU_MAX_RETIRED && reclaim() >= STATEMACHINE_RCU_MAX_RETIRED) {
+            std::this_thread::yield();
+        }
+        _current.store(next.get(), std::memory_order_seq_cst);
+        const uint32_t epoch = _epoch.fetch_add(1, std::memory_order_seq_cst) + 1;
+        if (_owner) {
+            _retired[_retiredCount].object = _owner;
+            _retired[_retiredCount].epoch = epoch;
+            _retiredCount++;
+        }
+        _owner = next;
+        _version.fetch_add(1, std::memory_order_release);
+        reclaim();
+    }
+
+    // Releases every retired version whose grace period has ended; returns how many remain
+    size_t reclaim() {
+        const uint32_t oldest = oldestActiveEpoch();
+        size_t kept = 0;
+        for (size_t i = 0; i < _retiredCount; i++) {
+            if (oldest != 0 && oldest < _retired[i].epoch) {
+                _retired[kept++] = _retired[i];
+            }
+        }
+        for (size_t i = kept; i < _retiredCount; i++) {
+            _retired[i].object.reset();
+        }
+        _retiredCount = kept;
+        return kept;
+    }
+
+    // Waits until every retired version has been released
+    void synchronize() {
+        while (reclaim() > 0) {
+            std::this_thread::yield();
+        }
+    }
+
+    // Writer-side view of the current version
+    std::shared_ptr<const T> current() const { return _owner; }
+
+    // Reader-side access outside a guard is only safe on the writer thread
+    const T* get() const { return _current.load(std::memory_order_acquire); }
+
+    uint32_t getVersion() const { return _version.load(std::memory_order_acquire); }
+    size_t getRetiredCount() const { return _retiredCount; }
+
+private:
+    struct readerSlot {
+        std::atomic<uint32_t> epoch;        // 0 while outside a critical section
+        std::atomic<bool> registered;
+        uint32_t nesting;                   // Touched only by the owning reader
+        char pad[STATEMACHINE_CACHE_LINE_SIZE];
+    };
+
+    struct retiredVersion {
+        std::shared_ptr<const T> object;
+        uint32_t epoch;
+    };
+
+    const T* enter(int reader) const {
+        readerSlot& slot = _readers[reader];
+        if (slot.nesting++ == 0) {
+            // Announce before loading the pointer; seq_cst orders both against publish
+            slot.epoch.store(_epoch.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+        }
+        return _current.load(std::memory_order_seq_cst);
+    }
+
+    void leave(int reader) const {
+        readerSlot& slot = _readers[reader];
+        if (--slot.nesting == 0) {
+            slot.epoch.store(0, std::memory_order_release);
+        }
+    }
+
+    // Smallest epoch announced by a reader inside a critical section, 0 when none is
+    uint32_t oldestActiveEpoch() const {
+        uint32_t oldest = 0;
+        for (size_t i = 0; i < STATEMACHINE_RCU_MAX_READERS; i++) {
+            const uint32_t epoch = _readers[i].epoch.load(std::memory_order_seq_cst);
+            if (epoch != 0 && (oldest == 0 || epoch < oldest)) {
+                oldest = epoch;
+            }
+        }
+        return oldest;
+    }
+
+    std::atomic<const T*> _current;
+    std::atomic<uint32_t> _epoch;
+    std::atomic<uint32_t> _version;
+    mutable readerSlot _readers[STATEMACHINE_RCU_MAX_READERS];
+    std::shared_ptr<const T> _owner;
+    retiredVersion _retired[STATEMACHINE_RCU_MAX_RETIRED];
+    size_t _retiredCount;
+};
@@ -0,0 +1,69 @@
+#pragma once
+
+// Single-writer sequence lock for publishing small trivially copyable values to
+// readers on other cores or threads without a mutex.
+//
+// The writer bumps the sequence to odd, stores the payload and bumps it back to
+// even. A reader copies the payload between two sequence loads and retries when
+// they differ or are odd, so it never observes a half-written value. Writes are
+// wait-free; reads are lock-free and only retry while a write is in flight.
+// The payload is held in relaxed atomic words, which keeps concurrent access
+// well-defined (and quiet under ThreadSanitizer).
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+template <typename T>
+class seqlock {
+    static_assert(std::is_trivially_copyable<T>::value, "seqlock payload must be trivially copyable");
+
+public:
+    seqlock() : _sequence(0) {
+        for (size_t i = 0; i < WORDS; i++) {
+            _words[i].store(0, std::memory_order_relaxed);
+        }
+    }
+
+    // Writer side, from a single thread
+    void publish(const T& value) {
+        uint32_t buffer[WORDS] = {0};
+        memcpy(buffer, &value, sizeof(T));
+        const uint32_t sequence = _sequence.load(std::memory_order_relaxed);
+        _sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < WORDS; i++) {
+            _words[i].store(buffer[i], std::memory_order_relaxed);
+        }
+        _sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    // Reader side, from any thread
+    T read() const {
+        uint32_t buffer[WORDS];
+        uint32_t before;
+        uint32_t after;
+        do {
+            before = _sequence.load(std::memory_order_acquire);
+            for (size_t i = 0; i < WORDS; i++) {
+                buffer[i] = _words[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = _sequence.load(std::memory_order_relaxed);
+        } while ((before & 1) || before != after);
+        T value;
+        memcpy(&value, buffer, sizeof(T));
+        return value;
+    }
+
+    // Number of completed publishes
+    uint32_t version() const { return _sequence.load(std::memory_order_acquire) / 2; }
+
+private:
+    static const size_t WORDS = (sizeof(T) + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+
+    std::atomic<uint32_t> _sequence;
+    std::atomic<uint32_t> _words[WORDS];
+};
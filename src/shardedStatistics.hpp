@@ -0,0 +1,140 @@
+#pragma once
+
+// Transition counters for many threads at once: sessions on a worker pool, or
+// several machines on different cores reporting into one set of totals.
+//
+//   shardedStatistics<> fleetStats;
+//   stateMachineSession<improvedStateMachine, shardedStatistics<> > session(definition, &fleetStats);
+//   ...
+//   stateMachineStats totals = fleetStats.getStatistics();     // summed on demand
+//
+// One shared counter block makes every increment bounce its cache line between
+// cores. Here each thread (each core on ESP32) writes to its own shard, padded to
+// a cache line of its own, and getStatistics() adds the shards up only when asked.
+// Increments are relaxed atomic adds on a line that normally stays in the writer's
+// cache; threads beyond the shard count share shards and stay correct.
+//
+// This only pays off while writers really run in parallel. When they take turns
+// on one core the shard lookup costs more than the bouncing it avoids, so nothing
+// uses it by default: sessions opt in through their SharedStatistics parameter.
+// A basicStateMachine keeps its plain stateMachineStats, which only its own
+// processEvent writes; add() folds those in.
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include "eventQueue.hpp"
+#include "improvedStateMachine.hpp"
+
+#ifdef ESP_PLATFORM
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#endif
+
+// Counter shards per shardedStatistics; threads are spread round-robin
+#ifndef STATEMACHINE_STATISTICS_SHARDS
+    #define STATEMACHINE_STATISTICS_SHARDS 8
+#endif
+
+// Shard for the calling thread: the core on ESP32, a per-thread slot elsewhere
+#ifndef STATEMACHINE_STATISTICS_SHARD
+    #ifdef ESP_PLATFORM
+        #define STATEMACHINE_STATISTICS_SHARD() static_cast<size_t>(xPortGetCoreID())
+    #else
+        #define STATEMACHINE_STATISTICS_SHARD() statisticsThreadSlot()
+    #endif
+#endif
+
+inline size_t statisticsThreadSlot() {
+    static std::atomic<size_t> nextSlot(0);
+    thread_local size_t slot = nextSlot.fetch_add(1, std::memory_order_relaxed);
+    return slot;
+}
+
+template <size_t Shards = STATEMACHINE_STATISTICS_SHARDS>
+class shardedStatistics {
+    static_assert(Shards > 0, "shardedStatistics needs at least one shard");
+
+public:
+    shardedStatistics() { reset(); }
+
+    // One processed event: committed transitions count as an action execution and a
+    // state change, anything else as a failure
+    void recordEvent(bool committed) {
+        shard& s = local();
+        s.totalTransitions.fetch_add(1, std::memory_order_relaxed);
+        if (committed) {
+            s.actionExecutions.fetch_add(1, std::memory_order_relaxed);
+            s.stateChanges.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            s.failedTransitions.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    // Folds in a block of counters, e.g. a machine's statistics after a batch
+    void add(const stateMachineStats& delta) {
+        shard& s = local();
+        s.totalTransitions.fetch_add(delta.totalTransitions, std::memory_order_relaxed);
+        s.failedTransitions.fetch_add(delta.failedTransitions, std::memory_order_relaxed);
+        s.stateChanges.fetch_add(delta.stateChanges, std::memory_order_relaxed);
+        s.actionExecutions.fetch_add(delta.actionExecutions, std::memory_order_relaxed);
+        s.validationErrors.fetch_add(delta.validationErrors, std::memory_order_relaxed);
+        s.deferredOverflows.fetch_add(delta.deferredOverflows, std::memory_order_relaxed);
+        uint32_t seen = s.maxTransitionTime.load(std::memory_order_relaxed);
+        while (delta.maxTransitionTime > seen &&
+               !s.maxTransitionTime.compare_exchange_weak(seen, delta.maxTransitionTime, std::memory_order_relaxed)) {
+        }
+    }
+
+    // Sum over all shards. Counters written concurrently may be a few events apart,
+    // but each one is exact once the writers have stopped.
+    stateMachineStats getStatistics() const {
+        stateMachineStats total;
+        for (size_t i = 0; i < Shards; i++) {
+            const shard& s = _shards[i];
+            total.totalTransitions += s.totalTransitions.load(std::memory_order_relaxed);
+            total.failedTransitions += s.failedTransitions.load(std::memory_order_relaxed);
+            total.stateChanges += s.stateChanges.load(std::memory_order_relaxed);
+            total.actionExecutions += s.actionExecutions.load(std::memory_order_relaxed);
+            total.validationErrors += s.validationErrors.load(std::memory_order_relaxed);
+            total.deferredOverflows += s.deferredOverflows.load(std::memory_order_relaxed);
+            const uint32_t maxTime = s.maxTransitionTime.load(std::memory_order_relaxed);
+            if (maxTime > total.maxTransitionTime) {
+                total.maxTransitionTime = maxTime;
+            }
+        }
+        return total;
+    }
+
+    // Not concurrently with writers
+    void reset() {
+        for (size_t i = 0; i < Shards; i++) {
+            shard& s = _shards[i];
+            s.totalTransitions.store(0, std::memory_order_relaxed);
+            s.failedTransitions.store(0, std::memory_order_relaxed);
+            s.stateChanges.store(0, std::memory_order_relaxed);
+            s.actionExecutions.store(0, std::memory_order_relaxed);
+            s.validationErrors.store(0, std::memory_order_relaxed);
+            s.deferredOverflows.store(0, std::memory_order_relaxed);
+            s.maxTransitionTime.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    static constexpr size_t shardCount() { return Shards; }
+
+private:
+    struct shard {
+        std::atomic<uint32_t> totalTransitions;
+        std::atomic<uint32_t> failedTransitions;
+        std::atomic<uint32_t> stateChanges;
+        std::atomic<uint32_t> actionExecutions;
+        std::atomic<uint32_t> validationErrors;
+        std::atomic<uint32_t> deferredOverflows;
+        std::atomic<uint32_t> maxTransitionTime;
+        char pad[STATEMACHINE_CACHE_LINE_SIZE];
+    };
+
+    shard& local() { return _shards[STATEMACHINE_STATISTICS_SHARD() % Shards]; }
+
+    shard _shards[Shards];
+};
@@ -0,0 +1,149 @@
+#pragma once
+
+// Flyweight sessions over one shared, immutable transition table.
+//
+//   improvedStateMachine builder;
+//   builder.addTransition(...);                       // configure once
+//   auto definition = stateMachineDefinition<>::create(builder);
+//
+//   stateMachineSession<> session(definition);        // per client, a few dozen bytes
+//   uint16_t mask = session.processEvent(EVENT_BUTTON_1);
+//
+// The definition is a sealed copy of the configured machine held through
+// std::shared_ptr<const ...>, so any number of sessions (on any number of
+// threads) share its tables read-only and keep them warm in cache. A session
+// holds only the shared pointer, current/last state, scoreboard and counters.
+// Actions are shared too; they run with the context passed to processEvent.
+// Sessions that run on several cores at once can also report into one shared
+// counter object (e.g. shardedStatistics from shardedStatistics.hpp) for
+// fleet-wide totals; by default a session keeps only its own counters.
+
+#include <memory>
+#include "improvedStateMachine.hpp"
+
+// Default SharedStatistics of stateMachineSession: records nothing, compiles away
+struct noSharedStatistics {
+    void recordEvent(bool) {}
+};
+
+template <typename Machine = improvedStateMachine>
+class stateMachineDefinition {
+public:
+    using pointer = std::shared_ptr<const stateMachineDefinition>;
+
+    // Seals a copy of the configured machine; nullptr when validation fails
+    static pointer create(const Machine& configured, bool checkConflicts = true) {
+        std::shared_ptr<stateMachineDefinition> definition = std::make_shared<stateMachineDefinition>(configured);
+        if (definition->_table.seal(checkConflicts) != VALID) {
+            return pointer();
+        }
+        return definition;
+    }
+
+    explicit stateMachineDefinition(const Machine& configured) : _table(configured) {}
+
+    const stateTransition* matchTransition(pageID page, buttonID button, eventID event) const {
+        return _table.matchTransition(page, button, event);
+    }
+
+    const Machine& table() const { return _table; }
+    size_t getTransitionCount() const { return _table.getTransitionCount(); }
+
+private:
+    Machine _table;
+};
+
+template <typename Machine = improvedStateMachine, typename SharedStatistics = noSharedStatistics>
+class stateMachineSession {
+public:
+    using definitionPointer = typename stateMachineDefinition<Machine>::pointer;
+
+    // sharedStats (optional) receives every processed event in addition to this session's counters
+    explicit stateMachineSession(definitionPointer definition, SharedStatistics* sharedStats = nullptr)
+        : _definition(definition), _sharedStats(sharedStats) {
+        clearScoreboard();
+    }
+
+    void initializeState(pageID page = 0, buttonID button = 0) {
+        _currentState.page = page;
+        _currentState.button = button;
+        _lastState = _currentState;
+    }
+
+    void setState(pageID page = 0, buttonID button = 0) {
+        _lastState = _currentState;
+        _currentState.page = page;
+        _currentState.button = button;
+    }
+
+    // Same matching, action and redraw-mask rules as improvedStateMachine::processEvent
+    uint16_t processEvent(eventID event, void* context = nullptr) {
+        _stats.totalTransitions++;
+        const stateTransition* trans =
+            _definition->matchTransition(_currentState.page, _currentState.button, event);
+        if (!trans) {
+            _stats.failedTransitions++;
+            if (_sharedStats) _sharedStats->recordEvent(false);
+            return 0;
+        }
+
+        if (trans->action) {
+            try {
+                trans->action(trans->toPage, event, context);
+            } catch (...) {
+                _stats.failedTransitions++;
+                if (_sharedStats) _sharedStats->recordEvent(false);
+                return 0;
+            }
+        }
+        _stats.actionExecutions++;
+
+        _lastState = _currentState;
+        _currentState.page = trans->toPage;
+        _currentState.button = trans->toButton;
+        _stats.stateChanges++;
+        if (_sharedStats) _sharedStats->recordEvent(true);
+        updateScoreboard(_currentState.page);
+
+        uint16_t mask = 0;
+        if (_lastState.page != _currentState.page) mask |= REDRAW_MASK_PAGE;
+        if (_lastState.button != _currentState.button) mask |= REDRAW_MASK_BUTTON;
+        if ((mask & REDRAW_MASK_PAGE) && (mask & REDRAW_MASK_BUTTON)) mask |= REDRAW_MASK_FULL;
+        return mask;
+    }
+
+    pageID getCurrentPage() const { return _currentState.page; }
+    buttonID getCurrentButton() const { return _currentState.button; }
+    pageID getLastPage() const { return _lastState.page; }
+    buttonID getLastButton() const { return _lastState.button; }
+
+    stateMachineStats getStatistics() const { return _stats; }
+    void resetStatistics() { _stats = stateMachineStats(); }
+
+    uint32_t getScoreboard(uint8_t index) const {
+        return (index < STATEMACHINE_SCOREBOARD_NUM_SEGMENTS) ? _stateScoreboard[index] : 0;
+    }
+    void clearScoreboard() {
+        for (int i = 0; i < STATEMACHINE_SCOREBOARD_NUM_SEGMENTS; i++) {
+            _stateScoreboard[i] = 0;
+        }
+    }
+
+    const definitionPointer& definition() const { return _definition; }
+    SharedStatistics* sharedStatistics() const { return _sharedStats; }
+
+private:
+    void updateScoreboard(pageID id) {
+        const uint8_t segment = id / STATEMACHINE_SCOREBOARD_SEGMENT_SIZE;
+        if (segment < STATEMACHINE_SCOREBOARD_NUM_SEGMENTS) {
+            _stateScoreboard[segment] |= (1UL << (id % STATEMACHINE_SCOREBOARD_SEGMENT_SIZE));
+        }
+    }
+
+    definitionPointer _definition;
+    SharedStatistics* _sharedStats;
+    currentState _currentState;
+    currentState _lastState;
+    uint32_t _stateScoreboard[STATEMACHINE_SCOREBOARD_NUM_SEGMENTS];
+    stateMachineStats _stats;
+};
@@ -0,0 +1,267 @@
+#pragma once
+
+// C++20 awaitables for host-side tests and automation. Optional: include this
+// header explicitly; it compiles to nothing before C++20 or without <coroutine>.
+//
+//   stateMachineWaiters<improvedStateMachine> waiters(sm);
+//
+//   exampleTask drive() {
+//       committedTransition t = co_await waiters.nextTransition();
+//       co_await waiters.untilPage(MENU_RUN);
+//       co_await waiters.untilTransition(MENU_RUN, EVENT_BUTTON_6, MENU_MAIN);
+//   }
+//
+// While any coroutine is waiting, the waiters object is the machine's commit
+// observer (so coalesced event runs commit every step). Each
+// co_await links its awaiter (which lives in the coroutine frame) into an
+// intrusive list: registering and resuming are O(1) and nothing is allocated
+// per wait. Waiters resume at the commit point inside processEvent, after the
+// transition has been committed, in registration order; like an action, a
+// resumed coroutine may raise further events. Matched waiters wait for their
+// turn on a ready list in the waiters object, so a resumed coroutine may also
+// destroy another coroutine that is still waiting or already matched.
+
+#if __cplusplus >= 202002L && defined(__has_include)
+#if __has_include(<coroutine>)
+
+#include <coroutine>
+#include "improvedStateMachine.hpp"
+
+#define STATEMACHINE_HAS_COROUTINES 1
+
+// What a completed wait reports
+struct committedTransition {
+    currentState from;
+    currentState to;
+    eventID event;
+};
+
+template <typename Machine>
+class stateMachineWaiters {
+public:
+    class awaiter {
+    public:
+        // Already satisfied state waits complete without suspending
+        bool await_ready() const noexcept {
+            if (_kind == kind::STATE && matchesState(_owner->_machine.getCurrentPage(),
+                                                     _owner->_machine.getCurrentButton())) {
+                return true;
+            }
+            return false;
+        }
+
+        void await_suspend(std::coroutine_handle<> handle) noexcept {
+            _handle = handle;
+            _owner->link(this);
+        }
+
+        committedTransition await_resume() const noexcept {
+            if (_resumed) {
+                return _result;
+            }
+            committedTransition current;
+            current.from.page = _owner->_machine.getLastPage();
+            current.from.button = _owner->_machine.getLastButton();
+            current.to.page = _owner->_machine.getCurrentPage();
+            current.to.button = _owner->_machine.getCurrentButton();
+            current.event = DONT_CARE_EVENT;
+            return current;
+        }
+
+        // A frame destroyed while suspended leaves the waiting or ready list
+        ~awaiter() {
+            if (_linked) {
+                _owner->unlink(this);
+            } else if (_ready) {
+                _owner->unlinkReady(this);
+            }
+        }
+
+        awaiter(const awaiter&) = delete;
+        awaiter& operator=(const awaiter&) = delete;
+
+    private:
+        friend class stateMachineWaiters;
+        enum class kind : uint8_t { ANY, STATE, TRANSITION };
+
+        awaiter(stateMachineWaiters* owner, kind waitKind, pageID fromPage, eventID event,
+                pageID page, buttonID button)
+            : _owner(owner), _kind(waitKind), _fromPage(fromPage), _event(event), _page(page),
+              _button(button), _linked(false), _ready(false), _resumed(false), _prev(nullptr), _next(nullptr),
+              _batch(0) {}
+
+        bool matchesState(pageID page, buttonID button) const {
+            return (_page == DONT_CARE_PAGE || _page == page) && (_button == DONT_CARE_BUTTON || _button == button);
+        }
+
+        bool matches(const currentState& from, const currentState& to, eventID event) const {
+            switch (_kind) {
+            case kind::ANY:
+                return true;
+            case kind::STATE:
+                return matchesState(to.page, to.button);
+            case kind::TRANSITION:
+                return (_fromPage == DONT_CARE_PAGE || _fromPage == from.page) &&
+                       (_event == DONT_CARE_EVENT || _event == event) && matchesState(to.page, to.button);
+            }
+            return false;
+        }
+
+        stateMachineWaiters* _owner;
+        kind _kind;
+        pageID _fromPage;
+        eventID _event;
+        pageID _page;
+        buttonID _button;
+        bool _linked;
+        bool _ready;
+        bool _resumed;
+        awaiter* _prev;     // Waiting list while _linked, ready list while _ready
+        awaiter* _next;
+        uint32_t _batch;    // Commit that matched it
+        std::coroutine_handle<> _handle;
+        committedTransition _result;
+    };
+
+    explicit stateMachineWaiters(Machine& machine)
+        : _machine(machine), _head(nullptr), _tail(nullptr), _readyHead(nullptr), _commitCount(0) {}
+
+    ~stateMachineWaiters() {
+        if (_head) {
+            _machine.setCommitObserver(nullptr, nullptr);
+        }
+    }
+
+    stateMachineWaiters(const stateMachineWaiters&) = delete;
+    stateMachineWaiters& operator=(const stateMachineWaiters&) = delete;
+
+    // Completes on the next committed transition
+    awaiter nextTransition() {
+        return awaiter(this, awaiter::kind::ANY, DONT_CARE_PAGE, DONT_CARE_EVENT, DONT_CARE_PAGE, DONT_CARE_BUTTON);
+    }
+
+    // Completes once the machine is on page (and button); immediately if it already is
+    awaiter untilPage(pageID page) {
+        return awaiter(this, awaiter::kind::STATE, DONT_CARE_PAGE, DONT_CARE_EVENT, page, DONT_CARE_BUTTON);
+    }
+
+    awaiter untilState(pageID page, buttonID button) {
+        return awaiter(this, awaiter::kind::STATE, DONT_CARE_PAGE, DONT_CARE_EVENT, page, button);
+    }
+
+    // Completes on a transition fromPage --event--> toPage; DONT_CARE_* values match anything
+    awaiter untilTransition(pageID fromPage, eventID event, pageID toPage = DONT_CARE_PAGE) {
+        return awaiter(this, awaiter::kind::TRANSITION, fromPage, event, toPage, DONT_CARE_BUTTON);
+    }
+
+    size_t waitingCount() const {
+        size_t count = 0;
+        for (const awaiter* w = _head; w; w = w->_next) count++;
+        return count;
+    }
+
+private:
+    // The observer is set only while the list is non-empty
+    void link(awaiter* w) {
+        if (!_head) {
+            _machine.setCommitObserver(&stateMachineWaiters::onCommit, this);
+        }
+        w->_linked = true;
+        w->_prev = _tail;
+        w->_next = nullptr;
+        if (_tail) {
+            _tail->_next = w;
+        } else {
+            _head = w;
+        }
+        _tail = w;
+    }
+
+    void unlink(awaiter* w) {
+        if (w->_prev) {
+            w->_prev->_next = w->_next;
+        } else {
+            _head = w->_next;
+        }
+        if (w->_next) {
+            w->_next->_prev = w->_prev;
+        } else {
+            _tail = w->_prev;
+        }
+        w->_linked = false;
+        w->_prev = nullptr;
+        w->_next = nullptr;
+        if (!_head) {
+            _machine.setCommitObserver(nullptr, nullptr);
+        }
+    }
+
+    void unlinkReady(awaiter* w) {
+        if (w->_prev) {
+            w->_prev->_next = w->_next;
+        } else {
+            _readyHead = w->_next;
+        }
+        if (w->_next) {
+            w->_next->_prev = w->_prev;
+        }
+        w->_ready = false;
+        w->_prev = nullptr;
+        w->_next = nullptr;
+    }
+
+    // Matching waiters move to the front of the ready list before any is resumed,
+    // so coroutines that wait again only see later commits. A commit raised by a
+    // resumed coroutine puts its batch in front and drains it first, then the
+    // outer commit carries on with what is left of its own batch.
+    static void onCommit(void* user, const currentState& from, const currentState& to, eventID event) {
+        stateMachineWaiters* self = static_cast<stateMachineWaiters*>(user);
+        const uint32_t batch = ++self->_commitCount;
+        awaiter* batchHead = nullptr;
+        awaiter* batchTail = nullptr;
+        awaiter* w = self->_head;
+        while (w) {
+            awaiter* next = w->_next;
+            if (w->matches(from, to, event)) {
+                self->unlink(w);
+                w->_result.from = from;
+                w->_result.to = to;
+                w->_result.event = event;
+                w->_resumed = true;
+                w->_ready = true;
+                w->_batch = batch;
+                w->_prev = batchTail;
+                if (batchTail) {
+                    batchTail->_next = w;
+                } else {
+                    batchHead = w;
+                }
+                batchTail = w;
+            }
+            w = next;
+        }
+        if (!batchHead) {
+            return;
+        }
+        batchTail->_next = self->_readyHead;
+        if (self->_readyHead) {
+            self->_readyHead->_prev = batchTail;
+        }
+        self->_readyHead = batchHead;
+
+        while (self->_readyHead && self->_readyHead->_batch == batch) {
+            awaiter* ready = self->_readyHead;
+            self->unlinkReady(ready);
+            ready->_handle.resume();
+        }
+    }
+
+    Machine& _machine;
+    awaiter* _head;
+    awaiter* _tail;
+    awaiter* _readyHead;
+    uint32_t _commitCount;
+};
+
+#endif // __has_include(<coroutine>)
+#endif // C++20
@@ -0,0 +1,199 @@
+#pragma once
+
+// Compile-time state machine variant for menu trees that are fixed at build time.
+//
+//   static void onStart(pageID toPage, eventID event, void* context);
+//
+//   using motorTable = staticTable<
+//       staticTransition<MENU_MAIN, 0, EVENT_BUTTON_1, MENU_RUN, 0, onStart>,
+//       staticTransition<MENU_RUN, 0, EVENT_BUTTON_6, MENU_MAIN, 0>,
+//       staticTransition<DONT_CARE_PAGE, 0, EVENT_HOME, MENU_MAIN, 0>>;
+//
+//   staticStateMachine<motorTable> sm;
+//   uint16_t mask = sm.processEvent(EVENT_BUTTON_1);
+//
+// The rows are a constexpr array placed in .rodata (flash on ESP32), invalid,
+// duplicate and conflicting rows fail with static_assert using the same rules
+// as improvedStateMachine::validateTransition, and lookup is a recursive chain
+// of constant key compares with first-match priority: O(rows), like the linear
+// scan, but with no table in RAM. No addTransition calls or runtime validation
+// are needed.
+//
+// staticStateMachine follows processEvent: actions run before the state changes,
+// a throwing action fails the event and keeps the state, and statistics and the
+// scoreboard are kept the same way. It has no pages, timers, queues or observers.
+
+#include "improvedStateMachine.hpp"
+
+// Actions are plain functions with the actionFunction signature
+using staticAction = void (*)(pageID, eventID, void*);
+
+// One row of a compiled table
+struct staticTransitionRow {
+    uint32_t key;
+    uint32_t care;
+    pageID toPage;
+    buttonID toButton;
+    staticAction action;
+};
+
+template <pageID FromPage, buttonID FromButton, eventID Event,
+          pageID ToPage, buttonID ToButton, staticAction Action = nullptr>
+struct staticTransition {
+    static constexpr uint32_t key = packTransitionKey(FromPage, FromButton, Event);
+    static constexpr uint32_t care = packTransitionCare(FromPage, FromButton, Event,
+                                                        DONT_CARE_PAGE, DONT_CARE_BUTTON, DONT_CARE_EVENT);
+    static constexpr pageID toPage = ToPage;
+    static constexpr buttonID toButton = ToButton;
+    static constexpr staticAction action = Action;
+
+    // Source fields may also be the DONT_CARE wildcard
+    static_assert(FromPage <= DONT_CARE_PAGE, "staticTransition: invalid fromPage");
+    static_assert(FromButton <= DONT_CARE_BUTTON, "staticTransition: invalid fromButton");
+    static_assert(ToPage < DONT_CARE_PAGE, "staticTransition: invalid toPage");
+    static_assert(ToButton < DONT_CARE_BUTTON, "staticTransition: invalid toButton");
+    static_assert(Event <= STATEMACHINE_MAX_EVENTS, "staticTransition: invalid event");
+};
+
+// Same rule as improvedStateMachine::transitionsConflict
+template <typename A, typename B>
+struct staticTransitionsConflict {
+    static constexpr bool sameDestination = A::toPage == B::toPage && A::toButton == B::toButton;
+    static constexpr bool value = (A::key == B::key && sameDestination) ||
+                                  (!sameDestination && keysOverlap(A::key, A::care, B::key, B::care));
+};
+
+template <typename T, typename... Rest>
+struct staticConflictsWithAny : std::false_type {};
+
+template <typename T, typename Next, typename... Rest>
+struct staticConflictsWithAny<T, Next, Rest...>
+    : std::integral_constant<bool, staticTransitionsConflict<T, Next>::value ||
+                                   staticConflictsWithAny<T, Rest...>::value> {};
+
+// Checks every row against the rows after it and emits the first-match chain
+template <typename... Ts>
+struct staticMatcher {
+    static int find(uint32_t, int) { return -1; }
+};
+
+template <typename T, typename... Rest>
+struct staticMatcher<T, Rest...> {
+    static_assert(!staticConflictsWithAny<T, Rest...>::value,
+                  "staticTable: transition duplicates or conflicts with a later transition");
+
+    static inline int find(uint32_t stateKey, int index) {
+        return keyMatches(T::key, T::care, stateKey) ? index : staticMatcher<Rest...>::find(stateKey, index + 1);
+    }
+};
+
+template <typename... Ts>
+struct staticTable {
+    static_assert(sizeof...(Ts) > 0, "staticTable: at least one transition is required");
+
+    static constexpr size_t size = sizeof...(Ts);
+    static constexpr staticTransitionRow rows[sizeof...(Ts)] = {
+        { Ts::key, Ts::care, Ts::toPage, Ts::toButton, Ts::action }...
+    };
+
+    // Index of the first matching row, or -1
+    static int find(pageID page, buttonID button, eventID event) {
+        return staticMatcher<Ts...>::find(packTransitionKey(page, button, event), 0);
+    }
+};
+
+template <typename... Ts>
+constexpr staticTransitionRow staticTable<Ts...>::rows[sizeof...(Ts)];
+
+// Runtime wrapper mirroring the improvedStateMachine event API
+template <typename Table>
+class staticStateMachine {
+private:
+    currentState _currentState;
+    currentState _lastState;
+    stateMachineStats _stats;
+    uint32_t _stateScoreboard[STATEMACHINE_SCOREBOARD_NUM_SEGMENTS];
+
+    void updateScoreboard(pageID id) {
+        const size_t segment = id / STATEMACHINE_SCOREBOARD_SEGMENT_SIZE;
+        if (segment < STATEMACHINE_SCOREBOARD_NUM_SEGMENTS) {
+            _stateScoreboard[segment] |= (1UL << (id % STATEMACHINE_SCOREBOARD_SEGMENT_SIZE));
+        }
+    }
+
+public:
+    staticStateMachine() : _stateScoreboard() {}
+
+    void initializeState(pageID page = 0, buttonID button = 0) {
+        _currentState.page = page;
+        _currentState.button = button;
+        _lastState = _currentState;
+    }
+
+    void setState(pageID page = 0, buttonID button = 0) {
+        _lastState = _currentState;
+        _currentState.page = page;
+        _currentState.button = button;
+    }
+
+    void forceState(pageID page = 0, buttonID button = 0) { setState(page, button); }
+
+    uint16_t processEvent(eventID event, void* context = nullptr) {
+        _stats.totalTransitions++;
+        if (event >= DONT_CARE_EVENT) {
+            _stats.failedTransitions++;
+            return 0;
+        }
+
+        int index = Table::find(_currentState.page, _currentState.button, event);
+        if (index < 0) {
+            _stats.failedTransitions++;
+            return 0;
+        }
+
+        const staticTransitionRow& row = Table::rows[index];
+        if (row.action) {
+            try {
+                row.action(row.toPage, event, context);
+            } catch (...) {
+                _stats.failedTransitions++;
+                return 0;
+            }
+        }
+        _stats.actionExecutions++;
+
+        _lastState = _currentState;
+        _currentState.page = row.toPage;
+        _currentState.button = row.toButton;
+        _stats.stateChanges++;
+        updateScoreboard(_currentState.page);
+
+        uint16_t mask = 0;
+        if (_lastState.page != _currentState.page) mask |= REDRAW_MASK_PAGE;
+        if (_lastState.button != _currentState.button) mask |= REDRAW_MASK_BUTTON;
+        if ((mask & REDRAW_MASK_PAGE) && (mask & REDRAW_MASK_BUTTON)) mask |= REDRAW_MASK_FULL;
+        return mask;
+    }
+
+    pageID getCurrentPage() const { return _currentState.page; }
+    pageID getPage() const { return getCurrentPage(); }
+    buttonID getCurrentButton() const { return _currentState.button; }
+    buttonID getButton() const { return getCurrentButton(); }
+    pageID getLastPage() const { return _lastState.page; }
+    buttonID getLastButton() const { return _lastState.button; }
+
+    uint32_t getScoreboard(uint8_t index) const {
+        return (index < STATEMACHINE_SCOREBOARD_NUM_SEGMENTS) ? _stateScoreboard[index] : 0;
+    }
+    void setScoreboard(uint32_t value, uint8_t index) {
+        if (index < STATEMACHINE_SCOREBOARD_NUM_SEGMENTS) _stateScoreboard[index] = value;
+    }
+    void clearScoreboard() {
+        for (int i = 0; i < STATEMACHINE_SCOREBOARD_NUM_SEGMENTS; i++) _stateScoreboard[i] = 0;
+    }
+
+    stateMachineStats getStatistics() const { return _stats; }
+    void resetStatistics() { _stats = stateMachineStats(); }
+
+    static size_t getTransitionCount() { return Table::size; }
+};
@@ -0,0 +1,269 @@
+#pragma once
+
+// Fixed-capacity hierarchical timing wheel used for page timeouts and scheduled events.
+//
+// Time is counted in ticks. Level 0 has one slot per tick; each level above covers
+// SlotBits more bits of the expiry tick, so four levels of 32 slots reach 2^20 ticks
+// (about 2.9 hours at 10 ms). Timers further out wait in the top level and are
+// re-placed as the wheel turns. Schedule and cancel are O(1). Advancing jumps
+// straight to the next occupied level-0 slot or level-0 wrap (found through an
+// occupancy mask), so it costs O(elapsed ticks / slots per level) plus the
+// timers it fires or cascades, not one visit per tick.
+//
+// Expired timers are moved onto a fired list in expiry order instead of being
+// called back, so the owner can process them (and arm or cancel other timers)
+// after the wheel has stopped turning. Timers live in a fixed pool; no heap is used.
+
+#include <cstdint>
+#include <cstddef>
+
+// Wheel geometry; 5 bits = 32 slots per level
+#ifndef STATEMACHINE_TIMER_WHEEL_BITS
+    #define STATEMACHINE_TIMER_WHEEL_BITS 5
+#endif
+
+#ifndef STATEMACHINE_TIMER_WHEEL_LEVELS
+    #define STATEMACHINE_TIMER_WHEEL_LEVELS 4
+#endif
+
+// A timer taken off the fired list
+struct expiredTimer {
+    int32_t handle;
+    uint8_t event;
+    uint8_t owner;
+    void* context;
+};
+
+template <size_t Capacity, uint8_t SlotBits = STATEMACHINE_TIMER_WHEEL_BITS,
+          uint8_t Levels = STATEMACHINE_TIMER_WHEEL_LEVELS>
+class timerWheel {
+    static_assert(Capacity > 0 && Capacity < 255, "timerWheel capacity must be 1..254");
+    static_assert(Levels > 0 && SlotBits * Levels <= 30, "timerWheel range must fit in 30 bits of ticks");
+    static_assert(SlotBits > 0 && SlotBits <= 5, "timerWheel level 0 must fit a 32-bit occupancy mask");
+
+public:
+    static constexpr uint8_t NO_OWNER = 0xFF;
+
+    timerWheel() { clear(); }
+
+    // Drops every timer and restarts at tick 0
+    void clear() {
+        _now = 0;
+        _active = 0;
+        _occupied = 0;
+        for (size_t i = 0; i < LIST_COUNT; i++) {
+            _head[i] = NONE;
+            _tail[i] = NONE;
+        }
+        for (size_t i = 0; i < Capacity; i++) {
+            _nodes[i].generation = 0;
+            append(FREE_LIST, static_cast<uint8_t>(i));
+        }
+    }
+
+    // Arms a timer delayTicks from now (at least one tick); a non-zero period re-arms it
+    // after each expiry. Returns a handle, or -1 when every timer is in use.
+    int32_t schedule(uint32_t delayTicks, uint8_t event, void* context,
+                     uint32_t periodTicks = 0, uint8_t owner = NO_OWNER) {
+        const uint8_t index = _head[FREE_LIST];
+        if (index == NONE) {
+            return -1;
+        }
+        unlink(index);
+        node& n = _nodes[index];
+        n.generation++;
+        n.event = event;
+        n.owner = owner;
+        n.context = context;
+        n.period = periodTicks;
+        n.expires = _now + (delayTicks ? delayTicks : 1);
+        place(index);
+        _active++;
+        return handleOf(index);
+    }
+
+    // Cancels a pending or fired-but-unprocessed timer; stale handles are ignored
+    bool cancel(int32_t handle) {
+        const uint8_t index = indexOf(handle);
+        if (index == NONE) {
+            return false;
+        }
+        unlink(index);
+        append(FREE_LIST, index);
+        _active--;
+        return true;
+    }
+
+    bool isPending(int32_t handle) const { return indexOf(handle) != NONE; }
+
+    // Turns the wheel up to nowTick, moving expired timers onto the fired list.
+    // Fired timers stay off the wheel until popped, so even a periodic timer fires
+    // at most once per call however far the clock jumped.
+    void advanceTo(uint32_t nowTick) {
+        if (_active == 0) {
+            _now = nowTick;
+            return;
+        }
+        while (static_cast<int32_t>(nowTick - _now) > 0) {
+            // Skip the ticks that neither expire a level-0 slot nor wrap level 0
+            const uint32_t position = _now & SLOT_MASK;
+            const uint32_t ahead = _occupied & ~((2UL << position) - 1);
+            const uint32_t next = ahead ? (_now & ~SLOT_MASK) + __builtin_ctz(ahead) : (_now | SLOT_MASK) + 1;
+            if (static_cast<int32_t>(nowTick - next) < 0) {
+                _now = nowTick;
+                return;
+            }
+            _now = next;
+            // Cascade every level whose lower neighbour just wrapped, highest first
+            uint8_t top = 0;
+            while (top + 1 < Levels && ((_now >> (SlotBits * top)) & SLOT_MASK) == 0) {
+                top++;
+            }
+            for (uint8_t level = top; level > 0; level--) {
+                cascade(level);
+            }
+            const uint8_t list = static_cast<uint8_t>(_now & SLOT_MASK);
+            while (_head[list] != NONE) {
+                const uint8_t index = _head[list];
+                unlink(index);
+                append(FIRED_LIST, index);
+            }
+        }
+    }
+
+    // Takes the oldest fired timer. One-shot timers are released; periodic ones are
+    // placed back on the wheel one period after the current tick.
+    bool popExpired(expiredTimer& out) {
+        const uint8_t index = _head[FIRED_LIST];
+        if (index == NONE) {
+            return false;
+        }
+        unlink(index);
+        node& n = _nodes[index];
+        out.handle = handleOf(index);
+        out.event = n.event;
+        out.owner = n.owner;
+        out.context = n.context;
+        if (n.period) {
+            n.expires = _now + n.period;
+            place(index);
+        } else {
+            append(FREE_LIST, index);
+            _active--;
+        }
+        return true;
+    }
+
+    uint32_t now() const { return _now; }
+    size_t activeCount() const { return _active; }
+    bool hasExpired() const { return _head[FIRED_LIST] != NONE; }
+    static constexpr size_t capacity() { return Capacity; }
+
+private:
+    static constexpr uint8_t NONE = 0xFF;
+    static constexpr uint32_t SLOTS = 1UL << SlotBits;
+    static constexpr uint32_t SLOT_MASK = SLOTS - 1;
+    // Wheel slots, then the fired and free lists
+    static constexpr size_t FIRED_LIST = SLOTS * Levels;
+    static constexpr size_t FREE_LIST = FIRED_LIST + 1;
+    static constexpr size_t LIST_COUNT = FREE_LIST + 1;
+
+    struct node {
+        uint32_t expires;
+        uint32_t period;
+        void* context;
+        uint8_t event;
+        uint8_t owner;
+        uint8_t generation;
+        uint8_t next;
+        uint8_t prev;
+        uint16_t list;
+    };
+
+    int32_t handleOf(uint8_t index) const {
+        return (static_cast<int32_t>(_nodes[index].generation) << 8) | index;
+    }
+
+    // Index for a live handle, or NONE
+    uint8_t indexOf(int32_t handle) const {
+        if (handle < 0) {
+            return NONE;
+        }
+        const uint8_t index = static_cast<uint8_t>(handle & 0xFF);
+        if (index >= Capacity || _nodes[index].list == FREE_LIST ||
+            _nodes[index].generation != static_cast<uint8_t>(handle >> 8)) {
+            return NONE;
+        }
+        return index;
+    }
+
+    // Lowest level whose slot span still separates the expiry from now
+    void place(uint8_t index) {
+        const uint32_t expires = _nodes[index].expires;
+        if (static_cast<int32_t>(expires - _now) <= 0) {
+            append(FIRED_LIST, index);
+            return;
+        }
+        for (uint8_t level = 0; level < Levels; level++) {
+            const uint8_t shift = SlotBits * level;
+            if ((expires >> shift) - (_now >> shift) < SLOTS) {
+                append(level * SLOTS + ((expires >> shift) & SLOT_MASK), index);
+                return;
+            }
+        }
+        // Beyond the wheel: park in the last top-level slot and re-place when it cascades
+        const uint8_t shift = SlotBits * (Levels - 1);
+        append((Levels - 1) * SLOTS + (((_now >> shift) + SLOT_MASK) & SLOT_MASK), index);
+    }
+
+    void cascade(uint8_t level) {
+        const size_t list = level * SLOTS + ((_now >> (SlotBits * level)) & SLOT_MASK);
+        while (_head[list] != NONE) {
+            const uint8_t index = _head[list];
+            unlink(index);
+            place(index);
+        }
+    }
+
+    void append(size_t list, uint8_t index) {
+        node& n = _nodes[index];
+        if (list < SLOTS) {
+            _occupied |= 1UL << list;
+        }
+        n.list = static_cast<uint16_t>(list);
+        n.next = NONE;
+        n.prev = _tail[list];
+        if (_tail[list] != NONE) {
+            _nodes[_tail[list]].next = index;
+        } else {
+            _head[list] = index;
+        }
+        _tail[list] = index;
+    }
+
+    void unlink(uint8_t index) {
+        node& n = _nodes[index];
+        if (n.prev != NONE) {
+            _nodes[n.prev].next = n.next;
+        } else {
+            _head[n.list] = n.next;
+        }
+        if (n.next != NONE) {
+            _nodes[n.next].prev = n.prev;
+        } else {
+            _tail[n.list] = n.prev;
+        }
+        if (n.list < SLOTS && _head[n.list] == NONE) {
+            _occupied &= ~(1UL << n.list);
+        }
+        n.next = NONE;
+        n.prev = NONE;
+    }
+
+    node _nodes[Capacity];
+    uint8_t _head[LIST_COUNT];
+    uint8_t _tail[LIST_COUNT];
+    uint32_t _now;
+    size_t _active;
+    uint32_t _occupied;     // Bit s set while level-0 slot s holds timers
+};
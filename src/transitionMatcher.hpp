@@ -0,0 +1,204 @@
+#pragma once
+
+// Packed transition keys and the first-match scan used by lookupStrategy::PACKED_SCAN.
+//
+// A transition is packed as a 32-bit key (page | button << 8 | event << 16) and
+// a care-mask with 0xFF in each specific field and 0x00 in each DONT_CARE field,
+// so a row matches a state when ((stateKey ^ key) & care) == 0. The packed form
+// is used for compile-time tables and conflict checks; the runtime scan keeps
+// one byte plane per field and tests each byte against the state and DONT_CARE.
+// The vector implementation is chosen at compile time:
+//   AVX2  - 32 rows per step (x86 hosts built with -mavx2)
+//   SSE2  - 16 rows per step (any x86-64 host)
+//   SWAR  - 4 rows per 32-bit word (Xtensa and other little-endian targets)
+//   scalar - define STATEMACHINE_MATCHER_SCALAR to force the plain loop
+// Defining STATEMACHINE_MATCHER_SWAR selects the word path on any host.
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+
+#if !defined(STATEMACHINE_MATCHER_SCALAR) && !defined(STATEMACHINE_MATCHER_SWAR)
+    #if defined(__AVX2__)
+        #include <immintrin.h>
+        #define STATEMACHINE_MATCHER_AVX2
+    #elif defined(__SSE2__) || defined(_M_X64)
+        #include <emmintrin.h>
+        #define STATEMACHINE_MATCHER_SSE2
+    #elif defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+        #define STATEMACHINE_MATCHER_SWAR
+    #endif
+#endif
+
+// Rows are stored in blocks of 32 so vector loads never run past the arrays
+#define STATEMACHINE_MATCHER_BLOCK 32
+
+constexpr uint32_t packTransitionKey(uint8_t page, uint8_t button, uint8_t event) {
+    return static_cast<uint32_t>(page) | (static_cast<uint32_t>(button) << 8) |
+           (static_cast<uint32_t>(event) << 16);
+}
+
+constexpr uint32_t packTransitionCare(uint8_t page, uint8_t button, uint8_t event,
+                                   uint8_t dontCarePage, uint8_t dontCareButton, uint8_t dontCareEvent) {
+    return ((page == dontCarePage) ? 0UL : 0x0000FFUL) |
+           ((button == dontCareButton) ? 0UL : 0x00FF00UL) |
+           ((event == dontCareEvent) ? 0UL : 0xFF0000UL);
+}
+
+// True when the key matches the packed state key
+constexpr bool keyMatches(uint32_t key, uint32_t care, uint32_t stateKey) {
+    return ((stateKey ^ key) & care) == 0;
+}
+
+// True when some (page, button, event) matches both keys
+constexpr bool keysOverlap(uint32_t key1, uint32_t care1, uint32_t key2, uint32_t care2) {
+    return ((key1 ^ key2) & care1 & care2) == 0;
+}
+
+// A mirror of the match fields of a transition table, not a split of it: the
+// stateTransition rows keep fromPage/fromButton/event as well, and set() must be
+// called whenever a row is written. Only the from-fields are stored, one byte
+// plane each (3 bytes per row rounded up to STATEMACHINE_MATCHER_BLOCK rows, i.e.
+// 192 bytes for the default 64-row table); DONT_CARE is recognised by value, so
+// every row must be set with the same DONT_CARE constants.
+template <size_t Capacity>
+struct transitionKeyPlanes {
+    static const size_t paddedCapacity =
+        ((Capacity + STATEMACHINE_MATCHER_BLOCK - 1) / STATEMACHINE_MATCHER_BLOCK) * STATEMACHINE_MATCHER_BLOCK;
+
+    uint8_t page[paddedCapacity];
+    uint8_t button[paddedCapacity];
+    uint8_t event[paddedCapacity];
+    uint8_t dontCarePage;
+    uint8_t dontCareButton;
+    uint8_t dontCareEvent;
+
+    transitionKeyPlanes() { clear(); }
+
+    void clear() {
+        memset(this, 0, sizeof(*this));
+    }
+
+    void set(size_t index, uint8_t fromPage, uint8_t fromButton, uint8_t evt,
+             uint8_t dcPage, uint8_t dcButton, uint8_t dcEvent) {
+        page[index] = fromPage;
+        button[index] = fromButton;
+        event[index] = evt;
+        dontCarePage = dcPage;
+        dontCareButton = dcButton;
+        dontCareEvent = dcEvent;
+    }
+
+    // True when both rows have the same from-fields
+    bool sameKey(size_t a, size_t b) const {
+        return page[a] == page[b] && button[a] == button[b] && event[a] == event[b];
+    }
+
+    bool matches(size_t index, uint8_t p, uint8_t b, uint8_t e) const {
+        return (page[index] == p || page[index] == dontCarePage) &&
+               (button[index] == b || button[index] == dontCareButton) &&
+               (event[index] == e || event[index] == dontCareEvent);
+    }
+
+    bool matches(size_t index, uint32_t stateKey) const {
+        return matches(index, static_cast<uint8_t>(stateKey), static_cast<uint8_t>(stateKey >> 8),
+                       static_cast<uint8_t>(stateKey >> 16));
+    }
+
+    // Reference implementation, one row at a time; returns count when no row matches
+    size_t findFirstScalar(size_t count, uint8_t p, uint8_t b, uint8_t e) const {
+        for (size_t i = 0; i < count; i++) {
+            if (matches(i, p, b, e)) {
+                return i;
+            }
+        }
+        return count;
+    }
+
+    // Same result as findFirstScalar using the compile-time selected vector path
+    size_t findFirst(size_t count, uint8_t p, uint8_t b, uint8_t e) const {
+#if defined(STATEMACHINE_MATCHER_AVX2)
+        const __m256i vp = _mm256_set1_epi8(static_cast<char>(p));
+        const __m256i vb = _mm256_set1_epi8(static_cast<char>(b));
+        const __m256i ve = _mm256_set1_epi8(static_cast<char>(e));
+        const __m256i dp = _mm256_set1_epi8(static_cast<char>(dontCarePage));
+        const __m256i db = _mm256_set1_epi8(static_cast<char>(dontCareButton));
+        const __m256i de = _mm256_set1_epi8(static_cast<char>(dontCareEvent));
+        for (size_t i = 0; i < count; i += 32) {
+            const __m256i rp = load256(page + i);
+            const __m256i rb = load256(button + i);
+            const __m256i re = load256(event + i);
+            __m256i hit = _mm256_or_si256(_mm256_cmpeq_epi8(rp, vp), _mm256_cmpeq_epi8(rp, dp));
+            hit = _mm256_and_si256(hit, _mm256_or_si256(_mm256_cmpeq_epi8(rb, vb), _mm256_cmpeq_epi8(rb, db)));
+            hit = _mm256_and_si256(hit, _mm256_or_si256(_mm256_cmpeq_epi8(re, ve), _mm256_cmpeq_epi8(re, de)));
+            uint32_t hits = static_cast<uint32_t>(_mm256_movemask_epi8(hit));
+            hits &= rowsMask(count - i, 32);
+            if (hits) {
+                return i + __builtin_ctz(hits);
+            }
+        }
+        return count;
+#elif defined(STATEMACHINE_MATCHER_SSE2)
+        const __m128i vp = _mm_set1_epi8(static_cast<char>(p));
+        const __m128i vb = _mm_set1_epi8(static_cast<char>(b));
+        const __m128i ve = _mm_set1_epi8(static_cast<char>(e));
+        const __m128i dp = _mm_set1_epi8(static_cast<char>(dontCarePage));
+        const __m128i db = _mm_set1_epi8(static_cast<char>(dontCareButton));
+        const __m128i de = _mm_set1_epi8(static_cast<char>(dontCareEvent));
+        for (size_t i = 0; i < count; i += 16) {
+            const __m128i rp = load128(page + i);
+            const __m128i rb = load128(button + i);
+            const __m128i re = load128(event + i);
+            __m128i hit = _mm_or_si128(_mm_cmpeq_epi8(rp, vp), _mm_cmpeq_epi8(rp, dp));
+            hit = _mm_and_si128(hit, _mm_or_si128(_mm_cmpeq_epi8(rb, vb), _mm_cmpeq_epi8(rb, db)));
+            hit = _mm_and_si128(hit, _mm_or_si128(_mm_cmpeq_epi8(re, ve), _mm_cmpeq_epi8(re, de)));
+            uint32_t hits = static_cast<uint32_t>(_mm_movemask_epi8(hit));
+            hits &= rowsMask(count - i, 16);
+            if (hits) {
+                return i + __builtin_ctz(hits);
+            }
+        }
+        return count;
+#elif defined(STATEMACHINE_MATCHER_SWAR)
+        const uint32_t vp = 0x01010101UL * p;
+        const uint32_t vb = 0x01010101UL * b;
+        const uint32_t ve = 0x01010101UL * e;
+        const uint32_t dp = 0x01010101UL * dontCarePage;
+        const uint32_t db = 0x01010101UL * dontCareButton;
+        const uint32_t de = 0x01010101UL * dontCareEvent;
+        for (size_t i = 0; i < count; i += 4) {
+            const uint32_t rp = load32(page + i);
+            const uint32_t rb = load32(button + i);
+            const uint32_t re = load32(event + i);
+            uint32_t hits = (zeroBytes(rp ^ vp) | zeroBytes(rp ^ dp)) &
+                            (zeroBytes(rb ^ vb) | zeroBytes(rb ^ db)) &
+                            (zeroBytes(re ^ ve) | zeroBytes(re ^ de));
+            if (count - i < 4) {
+                hits &= (1UL << ((count - i) * 8)) - 1;
+            }
+            if (hits) {
+                return i + (__builtin_ctz(hits) >> 3);
+            }
+        }
+        return count;
+#else
+        return findFirstScalar(count, p, b, e);
+#endif
+    }
+
+private:
+    static uint32_t rowsMask(size_t remaining, size_t width) {
+        return (remaining >= width) ? 0xFFFFFFFFUL : ((1UL << remaining) - 1);
+    }
+#if defined(STATEMACHINE_MATCHER_AVX2)
+    static __m256i load256(const uint8_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+#endif
+#if defined(STATEMACHINE_MATCHER_SSE2)
+    static __m128i load128(const uint8_t* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+#endif
+#if defined(STATEMACHINE_MATCHER_SWAR)
+    static uint32_t load32(const uint8_t* p) { uint32_t v; memcpy(&v, p, sizeof(v)); return v; }
+    // Exact per-byte zero test: bit 7 of each byte is set when that byte is zero
+    static uint32_t zeroBytes(uint32_t x) { return ~(((x & 0x7F7F7F7FUL) + 0x7F7F7F7FUL) | x | 0x7F7F7F7FUL); }
+#endif
+};
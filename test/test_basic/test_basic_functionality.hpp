@@ -23,7 +23,7 @@ extern int _enhancedUnityFailureCount;
 #else
 
 // =============================================================================
-// BASIC FUNCTIONALITY TESTS (25 tests)
+// BASIC FUNCTIONALITY TESTS (26 tests)
 // =============================================================================
 
 void test_001_basic_instantiation() {
@@ -367,6 +367,42 @@ void test_025_edge_case_transitions() {
     ENHANCED_UNITY_END_TEST_METHOD();
 }
 
+void test_026_button_config_strings() {
+    ENHANCED_UNITY_START_TEST_METHOD("test_026_button_config_strings", "test_basic_functionality.hpp", __LINE__);
+    TEST_ASSERT_EQUAL_INT_DEBUG(VALID, sm->addState(pageDefinition(1, "P1", "Page 1")));
+
+    sm->setButtonConfigPair(1, 0, "speed", "1200");
+    sm->setButtonConfigKey(1, 1, String("mode"));
+    sm->setButtonConfigValue(1, 1, "auto");
+    TEST_ASSERT_TRUE_DEBUG(strcmp(sm->getButtonConfigKeyView(1, 0), "speed") == 0);
+    TEST_ASSERT_TRUE_DEBUG(strcmp(sm->getButtonConfigValueView(1, 0), "1200") == 0);
+    TEST_ASSERT_TRUE_DEBUG(sm->getButtonConfigKey(1, 1) == "mode");
+    TEST_ASSERT_TRUE_DEBUG(sm->getButtonConfigPair(1, 1).second == "auto");
+
+    // Unknown pages and buttons read as empty and ignore writes
+    sm->setButtonConfigKey(9, 0, "lost");
+    sm->setButtonConfigKey(1, static_cast<buttonID>(menuTemplate::MAX_NUMBER_OF_BUTTONS), "lost");
+    TEST_ASSERT_TRUE_DEBUG(strcmp(sm->getButtonConfigKeyView(9, 0), "") == 0);
+    TEST_ASSERT_TRUE_DEBUG(strcmp(sm->getButtonConfigKeyView(1, 2), "") == 0);
+
+    // Copies carry the config
+    improvedStateMachine* copy = new improvedStateMachine(*sm);
+    TEST_ASSERT_TRUE_DEBUG(strcmp(copy->getButtonConfigValueView(1, 0), "1200") == 0);
+    delete copy;
+
+    // Inline storage truncates instead of allocating
+    fixedString<8> text("configuration");
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(7, text.length());
+    TEST_ASSERT_TRUE_DEBUG(text == "configu");
+    text = nullptr;
+    TEST_ASSERT_TRUE_DEBUG(text.isEmpty());
+#ifdef STATEMACHINE_FIXED_BUTTON_STRINGS
+    sm->setButtonConfigValue(1, 0, "a value longer than the inline buffer");
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(BUTTON_CONFIG_STRING_LENGTH - 1, strlen(sm->getButtonConfigValueView(1, 0)));
+#endif
+    ENHANCED_UNITY_END_TEST_METHOD();
+}
+
 // Expose registration function for shared runner
 void register_basic_tests() {
     RUN_TEST_DEBUG(test_001_basic_instantiation);
@@ -395,6 +431,7 @@ void register_basic_tests() {
     RUN_TEST_DEBUG(test_023_maximum_transitions);
     RUN_TEST_DEBUG(test_024_concurrent_event_processing);
     RUN_TEST_DEBUG(test_025_edge_case_transitions);
+    RUN_TEST_DEBUG(test_026_button_config_strings);
 }
 
 #endif // BUILDING_TEST_RUNNER_BUNDLE
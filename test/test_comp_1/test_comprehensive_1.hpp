@@ -1023,8 +1023,10 @@ void test_stress_testing() {
   uint32_t elapsed = millis() - startTime;
 
   Serial.printf("Stress test completed in %u ms\n", elapsed);
-  Serial.printf("Performance: %lu transitions/second\n",
-                (STRESS_TEST_ITERATIONS * 1000UL) / elapsed);
+  if (elapsed > 0) {
+    Serial.printf("Performance: %lu transitions/second\n",
+                  (STRESS_TEST_ITERATIONS * 1000UL) / elapsed);
+  }
   testStats.stressTests++;
   testStats.passedTests++;
   ENHANCED_UNITY_END_TEST_METHOD();
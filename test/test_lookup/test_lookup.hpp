@@ -0,0 +1,819 @@
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+
+#define BUILDING_TEST_RUNNER_BUNDLE 1
+#include "../test_common.hpp"
+#include "staticStateTable.hpp"
+#include "sharedStateMachine.hpp"
+#include <enhanced_unity.hpp>
+#include <vector>
+
+// External declaration for enhanced Unity failure counter
+extern int _enhancedUnityFailureCount;
+
+// Lookup test constants
+#define LOOKUP_TEST_PAGES 6
+#define LOOKUP_TEST_BUTTONS 4
+#define LOOKUP_TEST_EVENTS 8
+#define LOOKUP_TEST_RANDOM_TRANSITIONS 48
+#define LOOKUP_TEST_MATCHER_ROWS 61
+#define LOOKUP_TEST_MATCHER_PROBES 2000
+#define LOOKUP_TEST_SESSIONS 1000
+#define LOOKUP_TEST_MANY_PAGES 12
+#define LOOKUP_TEST_DISPATCH_PAGES 16
+
+// When this file is compiled standalone (not via the runner include), emit nothing
+#ifndef BUILDING_TEST_RUNNER_BUNDLE
+
+#else
+
+#include "../../example/motorControllerMenuConfig_fixed.cpp"
+
+// A default-capacity machine that carries a dispatch table
+using lookupDispatchMachine = basicStateMachine<STATEMACHINE_MAX_TRANSITIONS, STATEMACHINE_MAX_PAGES,
+                                                STATEMACHINE_MAX_BUTTONS, STATEMACHINE_MAX_EVENTS,
+                                                LOOKUP_TEST_DISPATCH_PAGES>;
+
+// Fill the machine (and the mirror, if any) with a random table mixing specific and
+// DONT_CARE rows. Validation is disabled so overlapping rows exercise first-match priority.
+template <typename Mirror>
+static void lookupFillRandomTable(improvedStateMachine* machine, Mirror* mirror) {
+    machine->setValidationEnabled(false);
+    if (mirror) mirror->setValidationEnabled(false);
+    for (int i = 0; i < LOOKUP_TEST_RANDOM_TRANSITIONS; i++) {
+        pageID fromPage = (getRandomNumber() % 5 == 0) ? DONT_CARE_PAGE : getRandomNumber() % LOOKUP_TEST_PAGES;
+        buttonID fromButton = (getRandomNumber() % 4 == 0) ? DONT_CARE_BUTTON : getRandomNumber() % LOOKUP_TEST_BUTTONS;
+        eventID event = (getRandomNumber() % 6 == 0) ? DONT_CARE_EVENT : getRandomNumber() % LOOKUP_TEST_EVENTS;
+        pageID toPage = getRandomNumber() % LOOKUP_TEST_PAGES;
+        buttonID toButton = getRandomNumber() % LOOKUP_TEST_BUTTONS;
+        machine->addTransition(stateTransition(fromPage, fromButton, event, toPage, toButton, nullptr));
+        if (mirror) mirror->addTransition(stateTransition(fromPage, fromButton, event, toPage, toButton, nullptr));
+    }
+}
+
+static void lookupFillRandomTable(improvedStateMachine* machine) {
+    lookupFillRandomTable<improvedStateMachine>(machine, nullptr);
+}
+
+// Run the same event against both machines from every (page, button) and compare outcomes
+template <typename Candidate>
+static void lookupCompareMachines(improvedStateMachine* reference, Candidate* candidate) {
+    for (pageID page = 0; page < LOOKUP_TEST_PAGES + 1; page++) {
+        for (buttonID button = 0; button < LOOKUP_TEST_BUTTONS + 1; button++) {
+            for (eventID event = 0; event < LOOKUP_TEST_EVENTS + 1; event++) {
+                reference->forceState(page, button);
+                candidate->forceState(page, button);
+                uint16_t referenceMask = reference->processEvent(event);
+                uint16_t candidateMask = candidate->processEvent(event);
+                TEST_ASSERT_EQUAL_UINT32_DEBUG(referenceMask, candidateMask);
+                TEST_ASSERT_EQUAL_UINT8_DEBUG(reference->getCurrentPage(), candidate->getCurrentPage());
+                TEST_ASSERT_EQUAL_UINT8_DEBUG(reference->getCurrentButton(), candidate->getCurrentButton());
+            }
+        }
+    }
+}
+
+// =============================================================================
+// TRANSITION LOOKUP TESTS
+// =============================================================================
+
+void test_201_dispatch_table_matches_linear_scan() {
+    ENHANCED_UNITY_START_TEST_METHOD("test_201_dispatch_table_matches_linear_scan", "test_lookup.hpp", __LINE__);
+    lookupDispatchMachine* dispatch = new lookupDispatchMachine();
+    lookupFillRandomTable(sm, dispatch);
+    dispatch->setLookupStrategy(lookupStrategy::DISPATCH_TABLE);
+    TEST_ASSERT_TRUE_DEBUG(dispatch->compileDispatchTable());
+    lookupCompareMachines(sm, dispatch);
+    delete dispatch;
+    ENHANCED_UNITY_END_TEST_METHOD();
+}
+
+void test_202_dispatch_table_first_match_priority() {
+    ENHANCED_UNITY_START_TEST_METHOD("test_202_dispatch_table_first_match_priority", "test_lookup.hpp", __LINE__);
+    lookupDispatchMachine* machine = new lookupDispatchMachine();
+    machine->setValidationEnabled(false);
+    machine->setLookupStrategy(lookupStrategy::DISPATCH_TABLE);
+    // Wildcard row added first must win over the later page-specific row
+    machine->addTransition(stateTransition(DONT_CARE_PAGE, DONT_CARE_BUTTON, 3, 9, 0, nullptr));
+    machine->addTransition(stateTransition(1, 0, 3, 2, 0, nullptr));
+    machine->addTransition(stateTransition(1, 0, 4, 2, 1, nullptr));
+    machine->initializeState(1, 0);
+    machine->processEvent(3);
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(9, machine->getCurrentPage());
+    machine->forceState(1, 0);
+    machine->processEvent(4);
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(2, machine->getCurrentPage());
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(1, machine->getCurrentButton());
+    TEST_ASSERT_TRUE_DEBUG(machine->isDispatchTableCompiled());
+    delete machine;
+    ENHANCED_UNITY_END_TEST_METHOD();
+}
+
+void test_203_dispatch_table_rebuilds_after_changes() {
+    ENHANCED_UNITY_START_TEST_METHOD("test_203_dispatch_table_rebuilds_after_changes", "test_lookup.hpp", __LINE__);
+    lookupDispatchMachine* machine = new lookupDispatchMachine();
+    machine->setLookupStrategy(lookupStrategy::DISPATCH_TABLE);
+    machine->addTransition(stateTransition(1, 0, 1, 2, 0, nullptr));
+    machine->initializeState(1, 0);
+    machine->processEvent(1);
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(2, machine->getCurrentPage());
+    TEST_ASSERT_TRUE_DEBUG(machine->isDispatchTableCompiled());
+
+    // A new row invalidates the table until the next lookup
+    machine->addTransition(stateTransition(2, 0, 1, 3, 0, nullptr));
+    TEST_ASSERT_FALSE_DEBUG(machine->isDispatchTableCompiled());
+    machine->processEvent(1);
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(3, machine->getCurrentPage());
+
+    machine->clearTransitions();
+    machine->forceState(1, 0);
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(0, machine->processEvent(1));
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(1, machine->getCurrentPage());
+    delete machine;
+    ENHANCED_UNITY_END_TEST_METHOD();
+}
+
+void test_204_dispatch_table_covers_every_page() {
+    ENHANCED_UNITY_START_TEST_METHOD("test_204_dispatch_table_covers_every_page", "test_lookup.hpp", __LINE__);
+    lookupDispatchMachine* machine = new lookupDispatchMachine();
+    machine->setLookupStrategy(lookupStrategy::DISPATCH_TABLE);
+    for (pageID page = 0; page < LOOKUP_TEST_MANY_PAGES; page++) {
+        machine->addTransition(stateTransition(page, 0, 1, page + 1, 0, nullptr));
+    }
+    TEST_ASSERT_TRUE_DEBUG(machine->compileDispatchTable());
+    TEST_ASSERT_TRUE_DEBUG(machine->isDispatchTableCompiled());
+    machine->initializeState(0, 0);
+    for (pageID page = 0; page < LOOKUP_TEST_MANY_PAGES; page++) {
+        machine->processEvent(1);
+        TEST_ASSERT_EQUAL_UINT8_DEBUG(page + 1, machine->getCurrentPage());
+    }
+    TEST_ASSERT_TRUE_DEBUG(machine->isDispatchTableCompiled());
+    delete machine;
+    ENHANCED_UNITY_END_TEST_METHOD();
+}
+
+void test_205_page_index_matches_linear_scan() {
+    ENHANCED_UNITY_START_TEST_METHOD("test_205_page_index_matches_linear_scan", "test_lookup.hpp", __LINE__);
+    lookupFillRandomTable(sm);
+    improvedStateMachine* indexed = new improvedStateMachine(*sm);
+    indexed->setLookupStrategy(lookupStrategy::PAGE_INDEX);
+    lookupCompareMachines(sm, indexed);
+    TEST_ASSERT_TRUE_DEBUG(indexed->isPageIndexBuilt());
+    delete indexed;
+    ENHANCED_UNITY_END_TEST_METHOD();
+}
+
+void test_206_page_index_merges_wildcards_in_order() {
+    ENHANCED_UNITY_START_TEST_METHOD("test_206_page_index_merges_wildcards_in_order", "test_lookup.hpp", __LINE__);
+    sm->setValidationEnabled(false);
+    sm->setLookupStrategy(lookupStrategy::PAGE_INDEX);
+    sm->addTransition(stateTransition(2, 0, 5, 3, 0, nullptr));
+    sm->addTransition(stateTransition(DONT_CARE_PAGE, 0, 5, 7, 0, nullptr));
+    sm->addTransition(stateTransition(4, 0, 5, 1, 0, nullptr));
+    sm->initializeState(2, 0);
+    sm->processEvent(5);
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(3, sm->getCurrentPage());
+    // Page 4 row was added after the wildcard, so the wildcard wins
+    sm->forceState(4, 0);
+    sm->processEvent(5);
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(7, sm->getCurrentPage());
+    // A page without its own bucket only sees the wildcard rows
+    sm->forceState(100, 0);
+    sm->processEvent(5);
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(7, sm->getCurrentPage());
+    ENHANCED_UNITY_END_TEST_METHOD();
+}
+
+void test_207_handled_events_mask() {
+    ENHANCED_UNITY_START_TEST_METHOD("test_207_handled_events_mask", "test_lookup.hpp", __LINE__);
+    sm->addTransition(stateTransition(1, 0, 2, 2, 0, nullptr));
+    sm->addTransition(stateTransition(1, DONT_CARE_BUTTON, 5, 3, 0, nullptr));
+    TEST_ASSERT_EQUAL_UINT32_DEBUG((1UL << 2) | (1UL << 5), sm->getHandledEvents(1, 0));
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(1UL << 5, sm->getHandledEvents(1, 3));
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(0, sm->getHandledEvents(2, 0));
+
+    // Wildcard pages reach pages indexed before and after them
+    sm->addTransition(stateTransition(DONT_CARE_PAGE, 1, 7, 4, 0, nullptr));
+    sm->addTransition(stateTransition(6, 1, 8, 4, 0, nullptr));
+    TEST_ASSERT_EQUAL_UINT32_DEBUG((1UL << 5) | (1UL << 7), sm->getHandledEvents(1, 1));
+    TEST_ASSERT_EQUAL_UINT32_DEBUG((1UL << 7) | (1UL << 8), sm->getHandledEvents(6, 1));
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(1UL << 7, sm->getHandledEvents(200, 1));
+
+    sm->addTransition(stateTransition(9, 2, DONT_CARE_EVENT, 4, 0, nullptr));
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(ALL_EVENTS_MASK, sm->getHandledEvents(9, 2));
+
+    sm->clearTransitions();
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(0, sm->getHandledEvents(1, 0));
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(0, sm->getHandledEvents(9, 2));
+    ENHANCED_UNITY_END_TEST_METHOD();
+}
+
+void test_208_unhandled_events_rejected() {
+    ENHANCED_UNITY_START_TEST_METHOD("test_208_unhandled_events_rejected", "test_lookup.hpp", __LINE__);
+    sm->addTransition(stateTransition(1, 0, 2, 2, 0, nullptr));
+    sm->initializeState(1, 0);
+    stateMachineStats before = sm->getStatistics();
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(0, sm->processEvent(3));
+    stateMachineStats after = sm->getStatistics();
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(1, sm->getCurrentPage());
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(before.totalTransitions + 1, after.totalTransitions);
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(before.failedTransitions + 1, after.failedTransitions);
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(REDRAW_MASK_PAGE, sm->processEvent(2));
+    ENHANCED_UNITY_END_TEST_METHOD();
+}
+
+void test_209_handled_events_for_many_pages() {
+    ENHANCED_UNITY_START_TEST_METHOD("test_209_handled_events_for_many_pages", "test_lookup.hpp", __LINE__);
+    for (pageID page = 0; page < LOOKUP_TEST_MANY_PAGES + 4; page++) {
+        sm->addTransition(stateTransition(page, 0, page % 8, page + 1, 0, nullptr));
+    }
+    for (pageID page = 0; page < LOOKUP_TEST_MANY_PAGES + 4; page++) {
+        TEST_ASSERT_EQUAL_UINT32_DEBUG(1UL << (page % 8), sm->getHandledEvents(page, 0));
+    }
+    sm->initializeState(LOOKUP_TEST_MANY_PAGES + 2, 0);
+    sm->processEvent((LOOKUP_TEST_MANY_PAGES + 2) % 8);
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(LOOKUP_TEST_MANY_PAGES + 3, sm->getCurrentPage());
+    ENHANCED_UNITY_END_TEST_METHOD();
+}
+
+void test_210_packed_scan_matches_linear_scan() {
+    ENHANCED_UNITY_START_TEST_METHOD("test_210_packed_scan_matches_linear_scan", "test_lookup.hpp", __LINE__);
+    lookupFillRandomTable(sm);
+    improvedStateMachine* packed = new improvedStateMachine(*sm);
+    packed->setLookupStrategy(lookupStrategy::PACKED_SCAN);
+    lookupCompareMachines(sm, packed);
+
+    // Assigned copies keep the packed keys
+    improvedStateMachine* copy = new improvedStateMachine();
+    *copy = *packed;
+    lookupCompareMachines(sm, copy);
+    delete copy;
+    delete packed;
+    ENHANCED_UNITY_END_TEST_METHOD();
+}
+
+void test_211_vector_matcher_matches_scalar() {
+    ENHANCED_UNITY_START_TEST_METHOD("test_211_vector_matcher_matches_scalar", "test_lookup.hpp", __LINE__);
+    transitionKeyPlanes<LOOKUP_TEST_MATCHER_ROWS>* planes = new transitionKeyPlanes<LOOKUP_TEST_MATCHER_ROWS>();
+    for (size_t i = 0; i < LOOKUP_TEST_MATCHER_ROWS; i++) {
+        pageID page = (getRandomNumber() % 8 == 0) ? DONT_CARE_PAGE : getRandomNumber() % LOOKUP_TEST_PAGES;
+        buttonID button = (getRandomNumber() % 8 == 0) ? DONT_CARE_BUTTON : getRandomNumber() % LOOKUP_TEST_BUTTONS;
+        eventID event = (getRandomNumber() % 8 == 0) ? DONT_CARE_EVENT : getRandomNumber() % LOOKUP_TEST_EVENTS;
+        planes->set(i, page, button, event, DONT_CARE_PAGE, DONT_CARE_BUTTON, DONT_CARE_EVENT);
+    }
+    // Every prefix length exercises full blocks as well as partial tails
+    for (int probe = 0; probe < LOOKUP_TEST_MATCHER_PROBES; probe++) {
+        size_t count = getRandomNumber() % (LOOKUP_TEST_MATCHER_ROWS + 1);
+        pageID page = getRandomNumber() % (LOOKUP_TEST_PAGES + 1);
+        buttonID button = getRandomNumber() % (LOOKUP_TEST_BUTTONS + 1);
+        eventID event = getRandomNumber() % (LOOKUP_TEST_EVENTS + 1);
+        TEST_ASSERT_EQUAL_UINT32_DEBUG(planes->findFirstScalar(count, page, button, event),
+                                       planes->findFirst(count, page, button, event));
+    }
+    delete planes;
+    ENHANCED_UNITY_END_TEST_METHOD();
+}
+
+void test_212_masked_key_conflict_detection() {
+    ENHANCED_UNITY_START_TEST_METHOD("test_212_masked_key_conflict_detection", "test_lookup.hpp", __LINE__);
+    sm->addTransition(stateTransition(1, 2, 3, 4, 0, nullptr));
+    // Wildcards overlapping the row with another destination conflict
+    TEST_ASSERT_EQUAL_INT_DEBUG(DUPLICATE_TRANSITION, sm->validateTransition(stateTransition(DONT_CARE_PAGE, 2, 3, 5, 0)));
+    TEST_ASSERT_EQUAL_INT_DEBUG(DUPLICATE_TRANSITION, sm->validateTransition(stateTransition(1, DONT_CARE_BUTTON, 3, 5, 0)));
+    TEST_ASSERT_EQUAL_INT_DEBUG(DUPLICATE_TRANSITION, sm->validateTransition(stateTransition(1, 2, DONT_CARE_EVENT, 5, 0)));
+    // Exact duplicate with the same destination
+    TEST_ASSERT_EQUAL_INT_DEBUG(DUPLICATE_TRANSITION, sm->validateTransition(stateTransition(1, 2, 3, 4, 0)));
+    // Overlap with the same destination, or any differing specific field, is fine
+    TEST_ASSERT_EQUAL_INT_DEBUG(VALID, sm->validateTransition(stateTransition(DONT_CARE_PAGE, 2, 3, 4, 0)));
+    TEST_ASSERT_EQUAL_INT_DEBUG(VALID, sm->validateTransition(stateTransition(2, 2, 3, 5, 0)));
+    TEST_ASSERT_EQUAL_INT_DEBUG(VALID, sm->validateTransition(stateTransition(DONT_CARE_PAGE, 1, 3, 5, 0)));
+    TEST_ASSERT_EQUAL_INT_DEBUG(VALID, sm->validateTransition(stateTransition(1, DONT_CARE_BUTTON, 4, 5, 0)));
+    ENHANCED_UNITY_END_TEST_METHOD();
+}
+
+static int lookupStaticActionCount = 0;
+
+static void lookupStaticAction(pageID, eventID, void*) {
+    lookupStaticActionCount++;
+}
+
+// Compile-time table covering specific, DONT_CARE and action rows
+using lookupStaticTable = staticTable<
+    staticTransition<0, 0, 1, 1, 0, lookupStaticAction>,
+    staticTransition<1, 0, 2, 2, 1>,
+    staticTransition<1, DONT_CARE_BUTTON, 3, 0, 2>,
+    staticTransition<2, 1, DONT_CARE_EVENT, 3, 0>,
+    staticTransition<DONT_CARE_PAGE, 0, 7, 0, 0>>;
+
+void test_213_static_table_matches_runtime_machine() {
+    ENHANCED_UNITY_START_TEST_METHOD("test_213_static_table_matches_runtime_machine", "test_lookup.hpp", __LINE__);
+    staticStateMachine<lookupStaticTable>* fixed = new staticStateMachine<lookupStaticTable>();
+    sm->addTransition(stateTransition(0, 0, 1, 1, 0, nullptr));
+    sm->addTransition(stateTransition(1, 0, 2, 2, 1, nullptr));
+    sm->addTransition(stateTransition(1, DONT_CARE_BUTTON, 3, 0, 2, nullptr));
+    sm->addTransition(stateTransition(2, 1, DONT_CARE_EVENT, 3, 0, nullptr));
+    sm->addTransition(stateTransition(DONT_CARE_PAGE, 0, 7, 0, 0, nullptr));
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(5, lookupStaticTable::size);
+
+    for (pageID page = 0; page < 4; page++) {
+        for (buttonID button = 0; button < 3; button++) {
+            for (eventID event = 0; event < LOOKUP_TEST_EVENTS; event++) {
+                sm->initializeState(page, button);
+                fixed->initializeState(page, button);
+                TEST_ASSERT_EQUAL_UINT32_DEBUG(sm->processEvent(event), fixed->processEvent(event));
+                TEST_ASSERT_EQUAL_UINT8_DEBUG(sm->getCurrentPage(), fixed->getCurrentPage());
+                TEST_ASSERT_EQUAL_UINT8_DEBUG(sm->getCurrentButton(), fixed->getCurrentButton());
+            }
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(sm->getStatistics().stateChanges, fixed->getStatistics().stateChanges);
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(sm->getStatistics().failedTransitions, fixed->getStatistics().failedTransitions);
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(sm->getScoreboard(0), fixed->getScoreboard(0));
+    delete fixed;
+    ENHANCED_UNITY_END_TEST_METHOD();
+}
+
+void test_214_static_table_actions_and_history() {
+    ENHANCED_UNITY_START_TEST_METHOD("test_214_static_table_actions_and_history", "test_lookup.hpp", __LINE__);
+    staticStateMachine<lookupStaticTable> fixed;
+    lookupStaticActionCount = 0;
+    fixed.initializeState(0, 0);
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(REDRAW_MASK_PAGE, fixed.processEvent(1));
+    TEST_ASSERT_EQUAL_INT_DEBUG(1, lookupStaticActionCount);
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(REDRAW_MASK_PAGE | REDRAW_MASK_BUTTON | REDRAW_MASK_FULL, fixed.processEvent(2));
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(1, fixed.getLastPage());
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(0, fixed.getLastButton());
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(2, fixed.getPage());
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(1, fixed.getButton());
+    TEST_ASSERT_EQUAL_UINT32_DEBUG((1UL << 1) | (1UL << 2), fixed.getScoreboard(0));
+    fixed.clearScoreboard();
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(0, fixed.getScoreboard(0));
+    // Unmatched and out-of-range events leave the state alone
+    fixed.setState(1, 1);
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(0, fixed.processEvent(4));
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(0, fixed.processEvent(DONT_CARE_EVENT));
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(1, fixed.getCurrentPage());
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(1, fixed.getCurrentButton());
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(2, fixed.getStatistics().failedTransitions);
+    // Table rows are constant data
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(packTransitionKey(1, DONT_CARE_BUTTON, 3), lookupStaticTable::rows[2].key);
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(0xFF00FFUL, lookupStaticTable::rows[2].care);
+    ENHANCED_UNITY_END_TEST_METHOD();
+}
+
+static void lookupStaticThrowingAction(pageID, eventID, void*) {
+    throw 1;
+}
+
+using lookupStaticThrowingTable = staticTable<
+    staticTransition<0, 0, 1, 1, 0, lookupStaticThrowingAction>>;
+
+void test_228_static_table_action_exception_keeps_state() {
+    ENHANCED_UNITY_START_TEST_METHOD("test_228_static_table_action_exception_keeps_state", "test_lookup.hpp", __LINE__);
+    staticStateMachine<lookupStaticThrowingTable> fixed;
+    sm->addTransition(stateTransition(0, 0, 1, 1, 0, lookupStaticThrowingAction));
+    sm->initializeState(0, 0);
+    fixed.initializeState(0, 0);
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(sm->processEvent(1), fixed.processEvent(1));
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(0, fixed.processEvent(1));
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(0, fixed.getCurrentPage());
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(0, fixed.getScoreboard(0));
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(0, fixed.getStatistics().stateChanges);
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(2, fixed.getStatistics().failedTransitions);
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(sm->getCurrentPage(), fixed.getCurrentPage());
+    ENHANCED_UNITY_END_TEST_METHOD();
+}
+
+static void lookupUserAction(pageID toPage, eventID, void*, void* user) {
+    *static_cast<int*>(user) += toPage;
+}
+
+void test_215_action_delegate_forms() {
+    ENHANCED_UNITY_START_TEST_METHOD("test_215_action_delegate_forms", "test_lookup.hpp", __LINE__);
+    actionDelegate empty(nullptr);
+    TEST_ASSERT_FALSE_DEBUG(static_cast<bool>(empty));
+
+    lookupStaticActionCount = 0;
+    actionDelegate plain(lookupStaticAction);
+    TEST_ASSERT_TRUE_DEBUG(static_cast<bool>(plain));
+    plain(1, 2, nullptr);
+    TEST_ASSERT_EQUAL_INT_DEBUG(1, lookupStaticActionCount);
+
+    int total = 0;
+    actionDelegate bound(lookupUserAction, &total);
+    bound(5, 0, nullptr);
+    TEST_ASSERT_EQUAL_INT_DEBUG(5, total);
+
+    int* counter = &total;
+    actionDelegate lambda([counter](pageID toPage, eventID event, void*) { *counter += toPage * event; });
+    lambda(3, 4, nullptr);
+    TEST_ASSERT_EQUAL_INT_DEBUG(17, total);
+
+    // Trivially copyable: a byte copy is a working delegate
+    actionDelegate copy;
+    memcpy(static_cast<void*>(&copy), &lambda, sizeof(copy));
+    copy(1, 1, nullptr);
+    TEST_ASSERT_EQUAL_INT_DEBUG(18, total);
+    ENHANCED_UNITY_END_TEST_METHOD();
+}
+
+void test_216_machine_runs_captured_actions() {
+    ENHANCED_UNITY_START_TEST_METHOD("test_216_machine_runs_captured_actions", "test_lookup.hpp", __LINE__);
+    int hits = 0;
+    int* counter = &hits;
+    sm->addTransition(stateTransition(0, 0, 1, 1, 0, [counter](pageID, eventID, void*) { (*counter)++; }));
+    sm->addTransition(stateTransition(1, 0, 1, 0, 0, nullptr));
+    sm->initializeState(0, 0);
+    sm->processEvent(1);
+    sm->processEvent(1);
+    sm->processEvent(1);
+    TEST_ASSERT_EQUAL_INT_DEBUG(2, hits);
+    // Copies of the machine carry the action with them
+    improvedStateMachine* copy = new improvedStateMachine(*sm);
+    copy->processEvent(1);
+    copy->processEvent(1);
+    TEST_ASSERT_EQUAL_INT_DEBUG(3, hits);
+    delete copy;
+    ENHANCED_UNITY_END_TEST_METHOD();
+}
+
+void test_217_sealed_machine_matches_unsealed() {
+    ENHANCED_UNITY_START_TEST_METHOD("test_217_sealed_machine_matches_unsealed", "test_lookup.hpp", __LINE__);
+    lookupFillRandomTable(sm);
+    // Rows on many pages, each with its own dispatch table slot once sealed
+    for (pageID page = 0; page <= LOOKUP_TEST_MANY_PAGES + 2; page++) {
+        sm->addTransition(stateTransition(page, 3, 7, (page + 1) % LOOKUP_TEST_PAGES, 0, nullptr));
+    }
+    sm->addTransition(stateTransition(DONT_CARE_PAGE, 3, 7, 5, 0, nullptr));
+    improvedStateMachine* sealed = new improvedStateMachine(*sm);
+    // The table overlaps on purpose, so only exact duplicates are checked
+    TEST_ASSERT_EQUAL_INT_DEBUG(DUPLICATE_TRANSITION, sealed->seal());
+    TEST_ASSERT_FALSE_DEBUG(sealed->isSealed());
+    TEST_ASSERT_EQUAL_INT_DEBUG(VALID, sealed->seal(false));
+    TEST_ASSERT_TRUE_DEBUG(sealed->isSealed());
+    lookupCompareMachines(sm, sealed);
+
+    // A copy of a sealed machine is sealed and ready to use
+    improvedStateMachine* copy = new improvedStateMachine(*sealed);
+    TEST_ASSERT_TRUE_DEBUG(copy->isSealed());
+    lookupCompareMachines(sm, copy);
+    delete copy;
+    delete sealed;
+    ENHANCED_UNITY_END_TEST_METHOD();
+}
+
+void test_218_sealed_machine_rejects_changes() {
+    ENHANCED_UNITY_START_TEST_METHOD("test_218_sealed_machine_rejects_changes", "test_lookup.hpp", __LINE__);
+    sm->addTransition(stateTransition(1, 0, 1, 2, 0, nullptr));
+    TEST_ASSERT_EQUAL_INT_DEBUG(VALID, sm->seal());
+    TEST_ASSERT_TRUE_DEBUG(sm->isPageIndexBuilt());
+
+    TEST_ASSERT_EQUAL_INT_DEBUG(MACHINE_SEALED, sm->addTransition(stateTransition(2, 0, 1, 3, 0, nullptr)));
+    TEST_ASSERT_EQUAL_INT_DEBUG(MACHINE_SEALED, sm->addTransition(stateTransition(2, 0, 1, 3, 0, nullptr), "test_218"));
+    TEST_ASSERT_EQUAL_INT_DEBUG(MACHINE_SEALED, sm->getLastErrorContext().errorCode);
+    TEST_ASSERT_EQUAL_INT_DEBUG(MACHINE_SEALED, sm->addState(pageDefinition(5, "P5", "Page 5")));
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(1, sm->getTransitionCount());
+
+    // Explicit reopen accepts changes again
+    sm->unseal();
+    TEST_ASSERT_EQUAL_INT_DEBUG(VALID, sm->addTransition(stateTransition(2, 0, 1, 3, 0, nullptr)));
+    TEST_ASSERT_EQUAL_INT_DEBUG(VALID, sm->seal());
+    sm->initializeState(1, 0);
+    sm->processEvent(1);
+    sm->processEvent(1);
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(3, sm->getCurrentPage());
+
+    sm->clearTransitions();
+    TEST_ASSERT_FALSE_DEBUG(sm->isSealed());
+    ENHANCED_UNITY_END_TEST_METHOD();
+}
+
+void test_219_seal_validates_and_deduplicates() {
+    ENHANCED_UNITY_START_TEST_METHOD("test_219_seal_validates_and_deduplicates", "test_lookup.hpp", __LINE__);
+    // Cheap setup: validation runs once in seal()
+    sm->setValidationEnabled(false);
+    sm->addTransition(stateTransition(1, 0, 1, 2, 0, nullptr));
+    sm->addTransition(stateTransition(1, 0, 1, 2, 0, nullptr));
+    sm->addTransition(stateTransition(2, 0, 1, 1, 0, nullptr));
+    sm->addTransition(stateTransition(1, 0, 1, 2, 0, nullptr));
+    TEST_ASSERT_EQUAL_INT_DEBUG(VALID, sm->seal());
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(2, sm->getTransitionCount());
+    sm->initializeState(1, 0);
+    sm->processEvent(1);
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(2, sm->getCurrentPage());
+    sm->processEvent(1);
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(1, sm->getCurrentPage());
+
+    // Invalid rows and conflicts keep the machine open
+    sm->clearTransitions();
+    sm->addTransition(stateTransition(1, 0, 1, DONT_CARE_PAGE, 0, nullptr));
+    TEST_ASSERT_EQUAL_INT_DEBUG(INVALID_PAGE_ID, sm->seal());
+    sm->clearTransitions();
+    sm->addTransition(stateTransition(1, 0, 1, 2, 0, nullptr));
+    sm->addTransition(stateTransition(DONT_CARE_PAGE, 0, 1, 3, 0, nullptr));
+    TEST_ASSERT_EQUAL_INT_DEBUG(DUPLICATE_TRANSITION, sm->seal());
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(1, sm->getLastErrorContext().transitionIndex);
+    TEST_ASSERT_FALSE_DEBUG(sm->isSealed());
+    ENHANCED_UNITY_END_TEST_METHOD();
+}
+
+// Small helper machine: 4 rows, 3 page definitions, 2 indexed buttons, 8 indexed events
+using lookupSmallMachine = basicStateMachine<4, 3, 2, 8>;
+// Table larger than the uint8_t index range
+using lookupLargeMachine = basicStateMachine<300, 4>;
+
+void test_220_small_capacity_machine() {
+    ENHANCED_UNITY_START_TEST_METHOD("test_220_small_capacity_machine", "test_lookup.hpp", __LINE__);
+    lookupSmallMachine* small = new lookupSmallMachine();
+    TEST_ASSERT_TRUE_DEBUG(sizeof(lookupSmallMachine) < sizeof(improvedStateMachine));
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(4, small->getMaxTransitions());
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(3, small->getMaxStates());
+
+    TEST_ASSERT_EQUAL_INT_DEBUG(VALID, small->addState(pageDefinition(0, "A", "Page A")));
+    TEST_ASSERT_EQUAL_INT_DEBUG(VALID, small->addState(pageDefinition(200, "B", "Page B")));
+    TEST_ASSERT_EQUAL_INT_DEBUG(VALID, small->addState(pageDefinition(7, "C", "Page C")));
+    TEST_ASSERT_EQUAL_INT_DEBUG(MAX_PAGES_EXCEEDED, small->addState(pageDefinition(8, "D", "Page D")));
+
+    // Page, button and event IDs keep the global range; only the storage shrinks
+    TEST_ASSERT_EQUAL_INT_DEBUG(VALID, small->addTransition(stateTransition(0, 0, 1, 200, 0, nullptr)));
+    TEST_ASSERT_EQUAL_INT_DEBUG(VALID, small->addTransition(stateTransition(200, 0, 20, 7, 5, nullptr)));
+    TEST_ASSERT_EQUAL_INT_DEBUG(VALID, small->addTransition(stateTransition(7, 5, 2, 0, 0, nullptr)));
+    TEST_ASSERT_EQUAL_INT_DEBUG(VALID, small->addTransition(stateTransition(DONT_CARE_PAGE, DONT_CARE_BUTTON, 3, 0, 0, nullptr)));
+    TEST_ASSERT_EQUAL_INT_DEBUG(MAX_TRANSITIONS_EXCEEDED, small->addTransition(stateTransition(0, 0, 4, 7, 0, nullptr)));
+
+    // Event 20 and button 5 are beyond the indexed range and use the scan
+    TEST_ASSERT_EQUAL_INT_DEBUG(VALID, small->seal());
+    small->initializeState(0, 0);
+    small->processEvent(1);
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(200, small->getCurrentPage());
+    small->processEvent(20);
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(7, small->getCurrentPage());
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(5, small->getCurrentButton());
+    small->processEvent(2);
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(0, small->getCurrentPage());
+    small->forceState(200, 5);
+    small->processEvent(3);
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(0, small->getCurrentPage());
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(0xFFUL, lookupSmallMachine::allEventsMask);
+    delete small;
+    ENHANCED_UNITY_END_TEST_METHOD();
+}
+
+void test_221_large_capacity_machine() {
+    ENHANCED_UNITY_START_TEST_METHOD("test_221_large_capacity_machine", "test_lookup.hpp", __LINE__);
+    lookupLargeMachine* large = new lookupLargeMachine();
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(2, sizeof(lookupLargeMachine::transitionIndex));
+    for (int i = 0; i < 300; i++) {
+        pageID page = i % 100;
+        TEST_ASSERT_EQUAL_INT_DEBUG(VALID, large->addTransition(stateTransition(page, 0, 1 + i / 100, (page + 1) % 100, 0, nullptr)));
+    }
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(0, large->getAvailableTransitions());
+    large->setLookupStrategy(lookupStrategy::PAGE_INDEX);
+    large->initializeState(99, 0);
+    large->processEvent(3);
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(0, large->getCurrentPage());
+    large->processEvent(2);
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(1, large->getCurrentPage());
+    delete large;
+    ENHANCED_UNITY_END_TEST_METHOD();
+}
+
+void test_222_session_matches_machine() {
+    ENHANCED_UNITY_START_TEST_METHOD("test_222_session_matches_machine", "test_lookup.hpp", __LINE__);
+    lookupFillRandomTable(sm);
+    sm->addTransition(stateTransition(DONT_CARE_PAGE, 3, 7, 5, 0, nullptr));
+    sm->addTransition(stateTransition(DONT_CARE_PAGE, 3, 7, 6, 0, nullptr));
+    stateMachineDefinition<>::pointer definition = stateMachineDefinition<>::create(*sm, false);
+    TEST_ASSERT_TRUE_DEBUG(definition != nullptr);
+    stateMachineSession<> session(definition);
+
+    for (pageID page = 0; page < LOOKUP_TEST_PAGES + 1; page++) {
+        for (buttonID button = 0; button < LOOKUP_TEST_BUTTONS + 1; button++) {
+            for (eventID event = 0; event < LOOKUP_TEST_EVENTS + 1; event++) {
+                sm->forceState(page, button);
+                session.setState(page, button);
+                TEST_ASSERT_EQUAL_UINT32_DEBUG(sm->processEvent(event), session.processEvent(event));
+                TEST_ASSERT_EQUAL_UINT8_DEBUG(sm->getCurrentPage(), session.getCurrentPage());
+                TEST_ASSERT_EQUAL_UINT8_DEBUG(sm->getCurrentButton(), session.getCurrentButton());
+            }
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(sm->getStatistics().stateChanges, session.getStatistics().stateChanges);
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(sm->getScoreboard(0), session.getScoreboard(0));
+
+    // Conflicting rows fail the default validation
+    TEST_ASSERT_TRUE_DEBUG(stateMachineDefinition<>::create(*sm) == nullptr);
+    ENHANCED_UNITY_END_TEST_METHOD();
+}
+
+void test_223_sessions_share_one_definition() {
+    ENHANCED_UNITY_START_TEST_METHOD("test_223_sessions_share_one_definition", "test_lookup.hpp", __LINE__);
+    uint32_t actionCount = 0;
+    uint32_t* actionCountPtr = &actionCount;
+    sm->addTransition(stateTransition(0, 0, 1, 1, 0, nullptr));
+    sm->addTransition(stateTransition(1, 0, 1, 2, 0,
+        [actionCountPtr](pageID, eventID, void*) { (*actionCountPtr)++; }));
+    sm->addTransition(stateTransition(DONT_CARE_PAGE, DONT_CARE_BUTTON, 2, 0, 0, nullptr));
+    stateMachineDefinition<>::pointer definition = stateMachineDefinition<>::create(*sm);
+    TEST_ASSERT_TRUE_DEBUG(definition != nullptr);
+    TEST_ASSERT_TRUE_DEBUG(definition->table().isSealed());
+
+    // Each session is orders of magnitude smaller than a full machine
+    TEST_ASSERT_TRUE_DEBUG(sizeof(stateMachineSession<>) * 100 < sizeof(improvedStateMachine));
+    printf("Session %u bytes, machine %u bytes\n", static_cast<unsigned>(sizeof(stateMachineSession<>)),
+           static_cast<unsigned>(sizeof(improvedStateMachine)));
+
+    std::vector<stateMachineSession<>> sessions(LOOKUP_TEST_SESSIONS, stateMachineSession<>(definition));
+    for (size_t i = 0; i < sessions.size(); i++) {
+        sessions[i].processEvent(1);
+        if (i % 2) sessions[i].processEvent(1);
+    }
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(LOOKUP_TEST_SESSIONS / 2, actionCount);
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(1, sessions[0].getCurrentPage());
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(2, sessions[1].getCurrentPage());
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(LOOKUP_TEST_SESSIONS + 1, definition.use_count());
+
+    // The definition is immutable: reconfiguring the builder does not affect sessions
+    sm->clearConfiguration();
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(REDRAW_MASK_PAGE, sessions[1].processEvent(2));
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(0, sessions[1].getCurrentPage());
+    ENHANCED_UNITY_END_TEST_METHOD();
+}
+
+void test_224_sparse_page_storage() {
+    ENHANCED_UNITY_START_TEST_METHOD("test_224_sparse_page_storage", "test_lookup.hpp", __LINE__);
+    // Sparse IDs map straight to their slots
+    TEST_ASSERT_EQUAL_INT_DEBUG(VALID, sm->addState(pageDefinition(249, "Last", "Last page")));
+    TEST_ASSERT_EQUAL_INT_DEBUG(VALID, sm->addState(pageDefinition(0, "First", "First page")));
+    TEST_ASSERT_EQUAL_INT_DEBUG(VALID, sm->addState(pageDefinition(17, "Mid", "Middle page")));
+    TEST_ASSERT_EQUAL_INT_DEBUG(DUPLICATE_PAGE, sm->addState(pageDefinition(17, "Again", "Again")));
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(3, sm->getStateCount());
+    TEST_ASSERT_TRUE_DEBUG(strcmp(sm->getState(249)->shortName, "Last") == 0);
+    TEST_ASSERT_TRUE_DEBUG(strcmp(sm->getState(17)->shortName, "Mid") == 0);
+    TEST_ASSERT_TRUE_DEBUG(sm->getState(1) == nullptr);
+    TEST_ASSERT_TRUE_DEBUG(sm->getState(DONT_CARE_PAGE) == nullptr);
+
+    // Filling the pool keeps existing pages in place; a heap pool then grows in chunks
+    const pageDefinition* first = sm->getState(0);
+#ifdef STATEMACHINE_PAGE_POOL_HEAP
+    const size_t fill = STATEMACHINE_PAGE_POOL_SIZE + 2 * STATEMACHINE_PAGE_POOL_CHUNK;
+#else
+    const size_t fill = sm->getMaxStates();
+#endif
+    for (pageID id = 100; sm->getStateCount() < fill; id++) {
+        TEST_ASSERT_EQUAL_INT_DEBUG(VALID, sm->addState(pageDefinition(id, "Pool", "Pool page")));
+    }
+#ifndef STATEMACHINE_PAGE_POOL_HEAP
+    TEST_ASSERT_EQUAL_INT_DEBUG(MAX_PAGES_EXCEEDED, sm->addState(pageDefinition(99, "Full", "Pool full")));
+#endif
+    TEST_ASSERT_TRUE_DEBUG(first == sm->getState(0));
+    sm->setButtonLabel(17, 1, "OK");
+    TEST_ASSERT_TRUE_DEBUG(strcmp(sm->getButtonLabel(17, 1), "OK") == 0);
+
+    // Copies own their pages
+    improvedStateMachine* copy = new improvedStateMachine(*sm);
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(sm->getStateCount(), copy->getStateCount());
+    TEST_ASSERT_TRUE_DEBUG(copy->getState(17) != sm->getState(17));
+    TEST_ASSERT_TRUE_DEBUG(strcmp(copy->getButtonLabel(17, 1), "OK") == 0);
+    sm->clearConfiguration();
+    TEST_ASSERT_TRUE_DEBUG(sm->getState(17) == nullptr);
+    TEST_ASSERT_TRUE_DEBUG(strcmp(copy->getState(249)->longName, "Last page") == 0);
+    *sm = *copy;
+    TEST_ASSERT_TRUE_DEBUG(strcmp(sm->getState(0)->shortName, "First") == 0);
+    delete copy;
+
+    // The machine reserves its page pool, not MaxPages pages
+    TEST_ASSERT_TRUE_DEBUG(sizeof(improvedStateMachine) < STATEMACHINE_MAX_PAGES * sizeof(pageDefinition));
+#if !defined(STATEMACHINE_PAGE_POOL_HEAP) && 2 * STATEMACHINE_PAGE_POOL_SIZE < STATEMACHINE_MAX_PAGES
+    typedef basicStateMachine<STATEMACHINE_MAX_TRANSITIONS, 2 * STATEMACHINE_PAGE_POOL_SIZE> twicePagesMachine;
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(sizeof(twicePagesMachine), sizeof(improvedStateMachine));
+#endif
+    printf("Machine %u bytes, %u bytes per stored page\n", static_cast<unsigned>(sizeof(improvedStateMachine)),
+           static_cast<unsigned>(sizeof(pageDefinition)));
+    ENHANCED_UNITY_END_TEST_METHOD();
+}
+
+void test_225_motor_menu_dispatch_table() {
+    ENHANCED_UNITY_START_TEST_METHOD("test_225_motor_menu_dispatch_table", "test_lookup.hpp", __LINE__);
+    typedef MotorControllerMenuConfig menu;
+    // The default machine has no table, so DISPATCH_TABLE lookups use the page index
+    menu::configureMotorControllerMenu(sm);
+    sm->setLookupStrategy(lookupStrategy::DISPATCH_TABLE);
+#if STATEMACHINE_DISPATCH_TABLE_PAGES == 0
+    TEST_ASSERT_FALSE_DEBUG(sm->compileDispatchTable());
+#endif
+
+    sm->initializeState(menu::MENU_MAIN, 0);
+    const eventID path[] = {menu::EVENT_BUTTON_2, menu::EVENT_BUTTON_1, menu::EVENT_BUTTON_3, menu::EVENT_BUTTON_6,
+                            menu::EVENT_BUTTON_4, menu::EVENT_BUTTON_3, menu::EVENT_BUTTON_1, menu::EVENT_HOME,
+                            menu::EVENT_BUTTON_1};
+    const pageID expected[] = {menu::MENU_SETUP, menu::MENU_SPEED, menu::MENU_SETUP, menu::MENU_MAIN,
+                               menu::MENU_SETTINGS, menu::MENU_NETWORK, menu::MENU_WIFI, menu::MENU_MAIN,
+                               menu::MENU_RUN};
+    for (size_t i = 0; i < sizeof(path) / sizeof(path[0]); i++) {
+        sm->processEvent(path[i]);
+        TEST_ASSERT_EQUAL_UINT8_DEBUG(expected[i], sm->getCurrentPage());
+    }
+    // Unhandled on the run page; the global BACK row still applies there
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(0, sm->processEvent(menu::EVENT_BUTTON_2));
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(menu::MENU_RUN, sm->getCurrentPage());
+    sm->processEvent(menu::EVENT_BACK);
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(menu::MENU_MAIN, sm->getCurrentPage());
+    ENHANCED_UNITY_END_TEST_METHOD();
+}
+
+void test_226_unhandled_events_rejected_on_many_pages() {
+    ENHANCED_UNITY_START_TEST_METHOD("test_226_unhandled_events_rejected_on_many_pages", "test_lookup.hpp", __LINE__);
+    for (pageID page = 0; page < LOOKUP_TEST_MANY_PAGES; page++) {
+        sm->addTransition(stateTransition(page, 0, 1, (page + 1) % LOOKUP_TEST_MANY_PAGES, 0, nullptr));
+    }
+    sm->addTransition(stateTransition(DONT_CARE_PAGE, 0, 4, 0, 0, nullptr));
+
+    // The last page is well past the old eight-page index and keeps an exact mask
+    const pageID last = LOOKUP_TEST_MANY_PAGES - 1;
+    TEST_ASSERT_EQUAL_UINT32_DEBUG((1UL << 1) | (1UL << 4), sm->getHandledEvents(last, 0));
+    sm->initializeState(last, 0);
+    stateMachineStats before = sm->getStatistics();
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(0, sm->processEvent(3));
+    stateMachineStats after = sm->getStatistics();
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(last, sm->getCurrentPage());
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(before.failedTransitions + 1, after.failedTransitions);
+    sm->processEvent(1);
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(0, sm->getCurrentPage());
+    ENHANCED_UNITY_END_TEST_METHOD();
+}
+
+// Two pages with rows, room for one in the table
+using lookupTinyDispatchMachine = basicStateMachine<8, 4, 2, 4, 1>;
+
+void test_227_dispatch_table_is_opt_in() {
+    ENHANCED_UNITY_START_TEST_METHOD("test_227_dispatch_table_is_opt_in", "test_lookup.hpp", __LINE__);
+    typedef basicStateMachine<STATEMACHINE_MAX_TRANSITIONS, STATEMACHINE_MAX_PAGES, STATEMACHINE_MAX_BUTTONS,
+                              STATEMACHINE_MAX_EVENTS, 0> noTableMachine;
+    // The table is the only difference, and a machine without one holds none of it
+    const size_t tableBytes = (LOOKUP_TEST_DISPATCH_PAGES + 1) * STATEMACHINE_MAX_BUTTONS * STATEMACHINE_MAX_EVENTS *
+                              sizeof(lookupDispatchMachine::transitionIndex);
+    const size_t delta = sizeof(lookupDispatchMachine) - sizeof(noTableMachine);
+    TEST_ASSERT_TRUE_DEBUG(delta >= tableBytes - sizeof(lookupDispatchMachine::transitionIndex));
+    TEST_ASSERT_TRUE_DEBUG(delta < tableBytes + 2 * sizeof(void*));
+#if STATEMACHINE_DISPATCH_TABLE_PAGES == 0
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(sizeof(noTableMachine), sizeof(improvedStateMachine));
+#endif
+
+    // More pages with rows than the table holds: compiling fails and lookups use the page index
+    lookupTinyDispatchMachine* machine = new lookupTinyDispatchMachine();
+    machine->setLookupStrategy(lookupStrategy::DISPATCH_TABLE);
+    machine->addTransition(stateTransition(0, 0, 1, 1, 0, nullptr));
+    TEST_ASSERT_TRUE_DEBUG(machine->compileDispatchTable());
+    machine->addTransition(stateTransition(1, 0, 1, 0, 1, nullptr));
+    TEST_ASSERT_FALSE_DEBUG(machine->compileDispatchTable());
+    machine->initializeState(0, 0);
+    machine->processEvent(1);
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(1, machine->getCurrentPage());
+    machine->processEvent(1);
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(0, machine->getCurrentPage());
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(1, machine->getCurrentButton());
+    TEST_ASSERT_FALSE_DEBUG(machine->isDispatchTableCompiled());
+    TEST_ASSERT_EQUAL_INT_DEBUG(VALID, machine->seal());
+    TEST_ASSERT_FALSE_DEBUG(machine->isDispatchTableCompiled());
+    machine->forceState(1, 0);
+    machine->processEvent(1);
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(0, machine->getCurrentPage());
+    delete machine;
+    ENHANCED_UNITY_END_TEST_METHOD();
+}
+
+// Expose registration function for shared runner
+void register_lookup_tests() {
+    RUN_TEST_DEBUG(test_201_dispatch_table_matches_linear_scan);
+    RUN_TEST_DEBUG(test_202_dispatch_table_first_match_priority);
+    RUN_TEST_DEBUG(test_203_dispatch_table_rebuilds_after_changes);
+    RUN_TEST_DEBUG(test_204_dispatch_table_covers_every_page);
+    RUN_TEST_DEBUG(test_205_page_index_matches_linear_scan);
+    RUN_TEST_DEBUG(test_206_page_index_merges_wildcards_in_order);
+    RUN_TEST_DEBUG(test_207_handled_events_mask);
+    RUN_TEST_DEBUG(test_208_unhandled_events_rejected);
+    RUN_TEST_DEBUG(test_209_handled_events_for_many_pages);
+    RUN_TEST_DEBUG(test_210_packed_scan_matches_linear_scan);
+    RUN_TEST_DEBUG(test_211_vector_matcher_matches_scalar);
+    RUN_TEST_DEBUG(test_212_masked_key_conflict_detection);
+    RUN_TEST_DEBUG(test_213_static_table_matches_runtime_machine);
+    RUN_TEST_DEBUG(test_214_static_table_actions_and_history);
+    RUN_TEST_DEBUG(test_215_action_delegate_forms);
+    RUN_TEST_DEBUG(test_216_machine_runs_captured_actions);
+    RUN_TEST_DEBUG(test_217_sealed_machine_matches_unsealed);
+    RUN_TEST_DEBUG(test_218_sealed_machine_rejects_changes);
+    RUN_TEST_DEBUG(test_219_seal_validates_and_deduplicates);
+    RUN_TEST_DEBUG(test_220_small_capacity_machine);
+    RUN_TEST_DEBUG(test_221_large_capacity_machine);
+    RUN_TEST_DEBUG(test_222_session_matches_machine);
+    RUN_TEST_DEBUG(test_223_sessions_share_one_definition);
+    RUN_TEST_DEBUG(test_224_sparse_page_storage);
+    RUN_TEST_DEBUG(test_225_motor_menu_dispatch_table);
+    RUN_TEST_DEBUG(test_226_unhandled_events_rejected_on_many_pages);
+    RUN_TEST_DEBUG(test_227_dispatch_table_is_opt_in);
+    RUN_TEST_DEBUG(test_228_static_table_action_exception_keeps_state);
+}
+
+#endif // BUILDING_TEST_RUNNER_BUNDLE
@@ -0,0 +1,41 @@
+// Suite-specific Unity test runner for transition lookup tests
+#include "../test_common.hpp"
+#include "test_lookup.hpp"
+
+// Define the shared test state machine used by all tests
+improvedStateMachine* sm = nullptr;
+
+// Unity lifecycle hooks
+void setUp() {
+    delete sm;
+    sm = new improvedStateMachine();
+}
+
+void tearDown() {
+    delete sm;
+    sm = nullptr;
+}
+
+void setup() {
+    ENHANCED_UNITY_INIT_SERIAL();
+    delay(5000);
+
+    // Fresh state machine before Unity begins
+    delete sm;
+    sm = new improvedStateMachine();
+
+#ifdef USE_BASELINE_UNITY
+    UNITY_BEGIN();
+    register_lookup_tests();
+    UNITY_END();
+#else
+    ENHANCED_UNITY_START_TEST_FILE("test_lookup.hpp");
+    register_lookup_tests();
+    ENHANCED_UNITY_FINAL_SUMMARY();
+    ENHANCED_UNITY_END_TEST_FILE("test_lookup.hpp");
+#endif
+}
+
+void loop() {
+    // No-op: tests execute in setup()
+}
@@ -12,6 +12,8 @@ extern "C" void enhancedUnityLinkAnchor();
 #include "../test_comp_4/test_random_coverage.hpp"
 #include "../test_comp_5/test_final_validation.hpp"
 #include "../test_conditional_compilation/test_conditional_compilation.hpp"
+#include "../test_lookup/test_lookup.hpp"
+#include "../test_queue/test_queue.hpp"
 //#include "../test_naming_consistency/test_naming_consistency.hpp"
 
 // Define the shared test state machine used by all tests
@@ -63,7 +65,9 @@ TestSuite testSuites[] = {
     {"Comprehensive Tests 3", register_statistics_scoreboard_tests, 0, 0, true, "test_statistics_scoreboard.hpp"},
     {"Comprehensive Tests 4", register_random_coverage_tests, 0, 0, true, "test_random_coverage.hpp"},
     {"Comprehensive Tests 5", register_final_validation_tests, 0, 0, true, "test_final_validation.hpp"},
-    {"Safety Tests", register_safety_tests, 0, 0, true, "test_safety.hpp"}
+    {"Safety Tests", register_safety_tests, 0, 0, true, "test_safety.hpp"},
+    {"Lookup Tests", register_lookup_tests, 0, 0, true, "test_lookup.hpp"},
+    {"Queue Tests", register_queue_tests, 0, 0, true, "test_queue.hpp"}
 };
 
 const int NUM_TEST_SUITES = sizeof(testSuites) / sizeof(testSuites[0]);
@@ -0,0 +1,1305 @@
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+
+#define BUILDING_TEST_RUNNER_BUNDLE 1
+#include "../test_common.hpp"
+#include "stateMachineAwait.hpp"
+#include "sharedStateMachine.hpp"
+#include "shardedStatistics.hpp"
+#include <enhanced_unity.hpp>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+// Threaded stress and throughput cases start std::threads and replay long streams,
+// so by default they only run in native (non-ARDUINO) builds
+#ifndef QUEUE_TEST_HOST_THREADS
+    #ifdef ARDUINO
+        #define QUEUE_TEST_HOST_THREADS 0
+    #else
+        #define QUEUE_TEST_HOST_THREADS 1
+    #endif
+#endif
+
+#if QUEUE_TEST_HOST_THREADS
+#include "fleetSimulator.hpp"
+#endif
+
+// External declaration for enhanced Unity failure counter
+extern int _enhancedUnityFailureCount;
+
+// Queue test constants
+#define QUEUE_TEST_THREAD_EVENTS 100000
+#define QUEUE_TEST_MAX_PRODUCERS 8
+#define QUEUE_TEST_EVENTS_PER_PRODUCER 20000
+#define QUEUE_TEST_FLEET_UNITS 512
+#define QUEUE_TEST_FLEET_MACHINES 6
+#define QUEUE_TEST_FLEET_EVENTS 2000
+#define QUEUE_TEST_LIVE_PUBLISHES 200
+#define QUEUE_TEST_STATS_THREADS 8
+#define QUEUE_TEST_STATS_EVENTS 20000
+#define QUEUE_TEST_STATS_BENCH_EVENTS 200000
+#define QUEUE_TEST_NAV_EVENTS ((1UL << 1) | (1UL << 2))   // RIGHT and LEFT of addButtonNavigation
+
+// When this file is compiled standalone (not via the runner include), emit nothing
+#ifndef BUILDING_TEST_RUNNER_BUNDLE
+
+#else
+
+// =============================================================================
+// EVENT QUEUE TESTS
+// =============================================================================
+
+void test_301_post_and_drain_in_order() {
+    ENHANCED_UNITY_START_TEST_METHOD("test_301_post_and_drain_in_order", "test_queue.hpp", __LINE__);
+    sm->addTransition(stateTransition(0, 0, 1, 1, 0, nullptr));
+    sm->addTransition(stateTransition(1, 0, 2, 2, 0, nullptr));
+    sm->addTransition(stateTransition(2, 0, 3, 3, 1, nullptr));
+    sm->initializeState(0, 0);
+
+    TEST_ASSERT_TRUE_DEBUG(sm->postEvent(1));
+    TEST_ASSERT_TRUE_DEBUG(sm->postEvent(2));
+    TEST_ASSERT_TRUE_DEBUG(sm->postEvent(3));
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(3, sm->getQueuedEventCount());
+    // Nothing runs until the owner drains
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(0, sm->getCurrentPage());
+
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(REDRAW_MASK_PAGE, sm->drainEvents(2));
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(2, sm->getCurrentPage());
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(1, sm->getQueuedEventCount());
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(REDRAW_MASK_PAGE | REDRAW_MASK_BUTTON | REDRAW_MASK_FULL, sm->drainEvents());
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(3, sm->getCurrentPage());
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(0, sm->drainEvents());
+    ENHANCED_UNITY_END_TEST_METHOD();
+}
+
+void test_302_queue_overflow_is_counted() {
+    ENHANCED_UNITY_START_TEST_METHOD("test_302_queue_overflow_is_counted", "test_queue.hpp", __LINE__);
+    for (int i = 0; i < STATEMACHINE_EVENT_QUEUE_SIZE; i++) {
+        TEST_ASSERT_TRUE_DEBUG(sm->postEvent(1));
+    }
+    TEST_ASSERT_FALSE_DEBUG(sm->postEvent(1));
+    TEST_ASSERT_FALSE_DEBUG(sm->postEvent(2));
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(2, sm->getQueueOverflowCount());
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(STATEMACHINE_EVENT_QUEUE_SIZE, sm->getQueuedEventCount());
+
+    sm->drainEvents(1);
+    TEST_ASSERT_TRUE_DEBUG(sm->postEvent(1));
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(2, sm->getQueueOverflowCount());
+    ENHANCED_UNITY_END_TEST_METHOD();
+}
+
+#if QUEUE_TEST_HOST_THREADS
+void test_303_threaded_producer_keeps_order() {
+    ENHANCED_UNITY_START_TEST_METHOD("test_303_threaded_producer_keeps_order", "test_queue.hpp", __LINE__);
+    // Every event carries its sequence number as context; the action checks arrival order
+    uintptr_t expected = 0;
+    uint32_t outOfOrder = 0;
+    uintptr_t* expectedPtr = &expected;
+    uint32_t* outOfOrderPtr = &outOfOrder;
+    auto check = [expectedPtr, outOfOrderPtr](pageID, eventID, void* context) {
+        if (reinterpret_cast<uintptr_t>(context) != *expectedPtr) (*outOfOrderPtr)++;
+        (*expectedPtr)++;
+    };
+    sm->addTransition(stateTransition(0, 0, 1, 1, 0, check));
+    sm->addTransition(stateTransition(1, 0, 2, 0, 0, check));
+    sm->initializeState(0, 0);
+
+    std::thread producer([]() {
+        for (uintptr_t i = 0; i < QUEUE_TEST_THREAD_EVENTS; i++) {
+            while (!sm->postEvent((i & 1) ? 2 : 1, reinterpret_cast<void*>(i))) {
+                std::this_thread::yield();
+            }
+        }
+    });
+    while (expected < QUEUE_TEST_THREAD_EVENTS) {
+        sm->drainEvents();
+    }
+    producer.join();
+
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(QUEUE_TEST_THREAD_EVENTS, expected);
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(0, outOfOrder);
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(0, sm->getQueuedEventCount());
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(QUEUE_TEST_THREAD_EVENTS, sm->getStatistics().stateChanges);
+    ENHANCED_UNITY_END_TEST_METHOD();
+}
+
+#endif
+
+// Records the lane (context >> 24) of every processed event
+struct queueLaneLog {
+    uint8_t lanes[64];
+    size_t count;
+};
+
+static void queueAddLaneLogger(improvedStateMachine* machine, queueLaneLog* log) {
+    machine->addTransition(stateTransition(DONT_CARE_PAGE, DONT_CARE_BUTTON, 1, 0, 0,
+        [log](pageID, eventID, void* context) {
+            if (log->count < sizeof(log->lanes)) {
+                log->lanes[log->count++] = static_cast<uint8_t>(reinterpret_cast<uintptr_t>(context) >> 24);
+            }
+        }));
+}
+
+void test_304_mpsc_round_robin_fairness() {
+    ENHANCED_UNITY_START_TEST_METHOD("test_304_mpsc_round_robin_fairness", "test_queue.hpp", __LINE__);
+    mpscEventQueue<3, 8>* queue = new mpscEventQueue<3, 8>();
+    queueLaneLog log = {{0}, 0};
+    queueAddLaneLogger(sm, &log);
+
+    TEST_ASSERT_EQUAL_INT_DEBUG(0, queue->registerProducer());
+    TEST_ASSERT_EQUAL_INT_DEBUG(1, queue->registerProducer());
+    TEST_ASSERT_EQUAL_INT_DEBUG(2, queue->registerProducer());
+    TEST_ASSERT_EQUAL_INT_DEBUG(-1, queue->registerProducer());
+
+    // A busy lane cannot starve the others
+    for (int i = 0; i < 6; i++) queue->push(0, 1, reinterpret_cast<void*>(uintptr_t(0) << 24));
+    for (int i = 0; i < 2; i++) queue->push(1, 1, reinterpret_cast<void*>(uintptr_t(1) << 24));
+    queue->push(2, 1, reinterpret_cast<void*>(uintptr_t(2) << 24));
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(9, queue->size());
+
+    queue->drainInto(*sm, 5);
+    const uint8_t firstBatch[5] = {0, 1, 2, 0, 1};
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(5, log.count);
+    for (size_t i = 0; i < 5; i++) TEST_ASSERT_EQUAL_UINT8_DEBUG(firstBatch[i], log.lanes[i]);
+
+    queue->drainInto(*sm);
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(9, log.count);
+    for (size_t i = 5; i < 9; i++) TEST_ASSERT_EQUAL_UINT8_DEBUG(0, log.lanes[i]);
+    TEST_ASSERT_TRUE_DEBUG(queue->empty());
+    delete queue;
+    ENHANCED_UNITY_END_TEST_METHOD();
+}
+
+void test_305_mpsc_statistics() {
+    ENHANCED_UNITY_START_TEST_METHOD("test_305_mpsc_statistics", "test_queue.hpp", __LINE__);
+    mpscEventQueue<2, 4>* queue = new mpscEventQueue<2, 4>();
+    sm->addTransition(stateTransition(0, 0, 1, 0, 0, nullptr));
+    for (int i = 0; i < 6; i++) queue->push(0, 1, nullptr);
+    queue->push(1, 1, nullptr);
+    TEST_ASSERT_FALSE_DEBUG(queue->push(2, 1, nullptr));
+
+    eventQueueStats stats = queue->getStatistics();
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(5, stats.enqueued);
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(2, stats.overflows);
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(4, stats.depthHighWater);
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(4, queue->getLaneHighWater(0));
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(1, queue->getLaneHighWater(1));
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(0, stats.drained);
+
+    queue->drainInto(*sm);
+    stats = queue->getStatistics();
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(5, stats.drained);
+    TEST_ASSERT_LE_UINT32_DEBUG(stats.maxLatency, stats.averageLatency);
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(5, sm->getStatistics().stateChanges);
+    delete queue;
+    ENHANCED_UNITY_END_TEST_METHOD();
+}
+
+#if QUEUE_TEST_HOST_THREADS
+void test_306_mpsc_producer_scaling() {
+    ENHANCED_UNITY_START_TEST_METHOD("test_306_mpsc_producer_scaling", "test_queue.hpp", __LINE__);
+    // Context = lane << 24 | sequence; the action checks per-producer order
+    uint32_t nextSequence[QUEUE_TEST_MAX_PRODUCERS] = {0};
+    uint32_t outOfOrder = 0;
+    uint32_t* nextPtr = nextSequence;
+    uint32_t* outOfOrderPtr = &outOfOrder;
+    sm->addTransition(stateTransition(DONT_CARE_PAGE, DONT_CARE_BUTTON, 1, 0, 0,
+        [nextPtr, outOfOrderPtr](pageID, eventID, void* context) {
+            uintptr_t value = reinterpret_cast<uintptr_t>(context);
+            uint32_t lane = static_cast<uint32_t>(value >> 24);
+            if ((value & 0xFFFFFF) != nextPtr[lane]) (*outOfOrderPtr)++;
+            nextPtr[lane]++;
+        }));
+
+    for (size_t producers = 1; producers <= QUEUE_TEST_MAX_PRODUCERS; producers *= 2) {
+        mpscEventQueue<QUEUE_TEST_MAX_PRODUCERS, 64>* queue = new mpscEventQueue<QUEUE_TEST_MAX_PRODUCERS, 64>();
+        for (size_t lane = 0; lane < QUEUE_TEST_MAX_PRODUCERS; lane++) nextSequence[lane] = 0;
+        const uint32_t total = static_cast<uint32_t>(producers * QUEUE_TEST_EVENTS_PER_PRODUCER);
+        const uint32_t changesBefore = sm->getStatistics().stateChanges;
+
+        unsigned long start = micros();
+        std::thread threads[QUEUE_TEST_MAX_PRODUCERS];
+        for (size_t p = 0; p < producers; p++) {
+            threads[p] = std::thread([queue]() {
+                int lane = queue->registerProducer();
+                for (uintptr_t i = 0; i < QUEUE_TEST_EVENTS_PER_PRODUCER; i++) {
+                    void* context = reinterpret_cast<void*>((uintptr_t(lane) << 24) | i);
+                    while (!queue->push(lane, 1, context)) {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+        while (sm->getStatistics().stateChanges - changesBefore < total) {
+            queue->drainInto(*sm, 32);
+        }
+        for (size_t p = 0; p < producers; p++) threads[p].join();
+        unsigned long elapsed = micros() - start;
+
+        eventQueueStats stats = queue->getStatistics();
+        TEST_ASSERT_EQUAL_UINT32_DEBUG(total, stats.enqueued);
+        TEST_ASSERT_EQUAL_UINT32_DEBUG(total, stats.drained);
+        if (elapsed > 0) {
+            printf("MPSC %u producer(s): %lu events/ms, max latency %u us, lane high-water %u\n",
+                   static_cast<unsigned>(producers), static_cast<unsigned long>(total) * 1000UL / elapsed,
+                   static_cast<unsigned>(stats.maxLatency), static_cast<unsigned>(stats.depthHighWater));
+        }
+        delete queue;
+    }
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(0, outOfOrder);
+    ENHANCED_UNITY_END_TEST_METHOD();
+}
+
+#endif
+
+void test_307_batch_matches_single_events() {
+    ENHANCED_UNITY_START_TEST_METHOD("test_307_batch_matches_single_events", "test_queue.hpp", __LINE__);
+    uint32_t actionCount = 0;
+    uint32_t* actionCountPtr = &actionCount;
+    sm->addTransition(stateTransition(0, 0, 1, 1, 0, nullptr));
+    sm->addTransition(stateTransition(1, 0, 1, 1, 1, nullptr));
+    sm->addTransition(stateTransition(1, 1, 2, 2, 3,
+        [actionCountPtr](pageID, eventID, void*) { (*actionCountPtr)++; }));
+    sm->addTransition(stateTransition(DONT_CARE_PAGE, DONT_CARE_BUTTON, 5, 0, 0, nullptr));
+    sm->initializeState(0, 0);
+    improvedStateMachine* single = new improvedStateMachine(*sm);
+
+    // Includes unhandled (3, 4) and invalid (DONT_CARE_EVENT) events
+    const eventID events[] = {1, 3, 1, 2, 4, DONT_CARE_EVENT, 5, 1, 1, 2, 5};
+    const size_t count = sizeof(events) / sizeof(events[0]);
+    uint16_t batchMasks[count];
+    uint16_t expectedMask = 0;
+
+    uint16_t mask = sm->processEvents(events, count, batchMasks);
+    for (size_t i = 0; i < count; i++) {
+        uint16_t singleMask = single->processEvent(events[i]);
+        TEST_ASSERT_EQUAL_UINT32_DEBUG(singleMask, batchMasks[i]);
+        expectedMask |= singleMask;
+    }
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(expectedMask, mask);
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(4, actionCount);
+
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(single->getCurrentPage(), sm->getCurrentPage());
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(single->getCurrentButton(), sm->getCurrentButton());
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(single->getLastPage(), sm->getLastPage());
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(single->getLastButton(), sm->getLastButton());
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(single->getScoreboard(0), sm->getScoreboard(0));
+
+    stateMachineStats batchStats = sm->getStatistics();
+    stateMachineStats singleStats = single->getStatistics();
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(singleStats.totalTransitions, batchStats.totalTransitions);
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(singleStats.failedTransitions, batchStats.failedTransitions);
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(singleStats.stateChanges, batchStats.stateChanges);
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(singleStats.actionExecutions, batchStats.actionExecutions);
+    delete single;
+    ENHANCED_UNITY_END_TEST_METHOD();
+}
+
+void test_308_batch_actions_see_live_state() {
+    ENHANCED_UNITY_START_TEST_METHOD("test_308_batch_actions_see_live_state", "test_queue.hpp", __LINE__);
+    pageID seenPage = 0;
+    pageID* seenPagePtr = &seenPage;
+    sm->addTransition(stateTransition(0, 0, 1, 1, 0, nullptr));
+    sm->addTransition(stateTransition(1, 0, 1, 2, 0,
+        [seenPagePtr](pageID, eventID, void*) { *seenPagePtr = sm->getCurrentPage(); }));
+    // An action that redirects the machine; the batch must continue from the new state
+    improvedStateMachine* machine = sm;
+    sm->addTransition(stateTransition(2, 0, 1, 3, 0,
+        [machine](pageID, eventID, void*) { machine->setState(5, 0); }));
+    sm->addTransition(stateTransition(3, 0, 1, 4, 0, nullptr));
+    sm->initializeState(0, 0);
+
+    const eventID events[] = {1, 1, 1, 1};
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(REDRAW_MASK_PAGE, sm->processEvents(events, 4));
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(1, seenPage);
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(4, sm->getCurrentPage());
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(3, sm->getLastPage());
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(0, sm->processEvents(events, 0));
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(4, sm->getStatistics().stateChanges);
+    ENHANCED_UNITY_END_TEST_METHOD();
+}
+
+void test_309_run_to_completion_commits_before_chained_event() {
+    ENHANCED_UNITY_START_TEST_METHOD("test_309_run_to_completion_commits_before_chained_event", "test_queue.hpp", __LINE__);
+    pageID seenPage = 99;
+    pageID* seenPagePtr = &seenPage;
+    improvedStateMachine* machine = sm;
+    sm->addTransition(stateTransition(0, 0, 1, 1, 0,
+        [machine](pageID, eventID, void*) { machine->processEvent(2); }));
+    sm->addTransition(stateTransition(1, 0, 2, 2, 0,
+        [machine, seenPagePtr](pageID, eventID, void*) { *seenPagePtr = machine->getCurrentPage(); }));
+
+    // Recursive default: the nested event runs from the half-updated state (page 0) and misses
+    sm->initializeState(0, 0);
+    sm->processEvent(1);
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(1, sm->getCurrentPage());
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(99, seenPage);
+
+    sm->enableRunToCompletion();
+    TEST_ASSERT_TRUE_DEBUG(sm->isRunToCompletionEnabled());
+    sm->initializeState(0, 0);
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(REDRAW_MASK_PAGE, sm->processEvent(1));
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(2, sm->getCurrentPage());
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(1, sm->getLastPage());
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(1, seenPage);
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(0, sm->getDeferredEventCount());
+
+    // Batches run deferred events before their next entry
+    const eventID events[] = {1, 2};
+    sm->initializeState(0, 0);
+    uint16_t masks[2];
+    sm->processEvents(events, 2, masks);
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(2, sm->getCurrentPage());
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(REDRAW_MASK_PAGE, masks[0]);
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(0, masks[1]);
+    ENHANCED_UNITY_END_TEST_METHOD();
+}
+
+void test_310_run_to_completion_bounds_chains() {
+    ENHANCED_UNITY_START_TEST_METHOD("test_310_run_to_completion_bounds_chains", "test_queue.hpp", __LINE__);
+    uint32_t chained = 0;
+    uint32_t* chainedPtr = &chained;
+    improvedStateMachine* machine = sm;
+    // A burst larger than the deferred queue
+    sm->addTransition(stateTransition(0, 0, 1, 0, 1,
+        [machine](pageID, eventID, void*) {
+            for (int i = 0; i < STATEMACHINE_DEFERRED_EVENT_QUEUE_SIZE + 2; i++) machine->processEvent(2);
+        }));
+    sm->addTransition(stateTransition(DONT_CARE_PAGE, DONT_CARE_BUTTON, 2, 0, 0, nullptr));
+    // A chain far deeper than STATEMACHINE_MAX_RECURSION_DEPTH
+    sm->addTransition(stateTransition(DONT_CARE_PAGE, DONT_CARE_BUTTON, 3, 0, 0,
+        [machine, chainedPtr](pageID, eventID, void*) {
+            if (++(*chainedPtr) < 5 * STATEMACHINE_MAX_RECURSION_DEPTH) machine->processEvent(3);
+        }));
+    sm->enableRunToCompletion();
+    sm->initializeState(0, 0);
+
+    sm->processEvent(1);
+    stateMachineStats stats = sm->getStatistics();
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(2, stats.deferredOverflows);
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(1 + STATEMACHINE_DEFERRED_EVENT_QUEUE_SIZE, stats.stateChanges);
+
+    sm->resetStatistics();
+    sm->processEvent(3);
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(5 * STATEMACHINE_MAX_RECURSION_DEPTH, chained);
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(5 * STATEMACHINE_MAX_RECURSION_DEPTH, sm->getStatistics().stateChanges);
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(0, sm->getStatistics().failedTransitions);
+    ENHANCED_UNITY_END_TEST_METHOD();
+}
+
+void test_311_coalesced_navigation_burst() {
+    ENHANCED_UNITY_START_TEST_METHOD("test_311_coalesced_navigation_burst", "test_queue.hpp", __LINE__);
+    std::array<pageID, STATEMACHINE_MAX_MENU_LABELS> targets = {};
+    sm->addButtonNavigation(1, 4, targets);   // RIGHT = 1, LEFT = 2
+    sm->initializeState(1, 0);
+    improvedStateMachine* single = new improvedStateMachine(*sm);
+
+    const eventID burst[] = {1, 1, 1, 1, 1, 2, 1};
+    const size_t count = sizeof(burst) / sizeof(burst[0]);
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(REDRAW_MASK_BUTTON, sm->processEventsCoalesced(burst, count, QUEUE_TEST_NAV_EVENTS));
+    single->processEvents(burst, count);
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(single->getCurrentButton(), sm->getCurrentButton());
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(1, sm->getCurrentPage());
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(1, sm->getCurrentButton());
+    // One net movement: the last state is where the burst started
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(0, sm->getLastButton());
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(count, sm->getStatistics().stateChanges);
+
+    // A burst that ends where it started needs no redraw
+    const eventID spin[] = {1, 1, 2, 2};
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(0, sm->processEventsCoalesced(spin, 4, QUEUE_TEST_NAV_EVENTS));
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(1, sm->getCurrentButton());
+    delete single;
+    ENHANCED_UNITY_END_TEST_METHOD();
+}
+
+void test_312_coalescing_stops_at_actions() {
+    ENHANCED_UNITY_START_TEST_METHOD("test_312_coalescing_stops_at_actions", "test_queue.hpp", __LINE__);
+    buttonID seenButton = 99;
+    buttonID* seenButtonPtr = &seenButton;
+    improvedStateMachine* machine = sm;
+    std::array<pageID, STATEMACHINE_MAX_MENU_LABELS> targets = {};
+    sm->addButtonNavigation(1, 4, targets);
+    sm->addTransition(stateTransition(1, 2, 5, 2, 0,
+        [machine, seenButtonPtr](pageID, eventID, void*) { *seenButtonPtr = machine->getCurrentButton(); }));
+    sm->initializeState(1, 0);
+
+    // RIGHT, RIGHT, unhandled, SELECT (has an action), then RIGHT on page 2 (unhandled)
+    const eventID events[] = {1, 1, 9, 5, 1};
+    uint16_t mask = sm->processEventsCoalesced(events, 5, QUEUE_TEST_NAV_EVENTS);
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(2, seenButton);
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(2, sm->getCurrentPage());
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(0, sm->getCurrentButton());
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(REDRAW_MASK_BUTTON | REDRAW_MASK_PAGE | REDRAW_MASK_FULL, mask);
+
+    stateMachineStats stats = sm->getStatistics();
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(5, stats.totalTransitions);
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(2, stats.failedTransitions);
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(3, stats.stateChanges);
+    ENHANCED_UNITY_END_TEST_METHOD();
+}
+
+// Injectable clock for the timer tests
+static uint32_t queueTestClockMs = 0;
+static uint32_t queueTestClock() { return queueTestClockMs; }
+
+void test_313_page_idle_timeout() {
+    ENHANCED_UNITY_START_TEST_METHOD("test_313_page_idle_timeout", "test_queue.hpp", __LINE__);
+    const eventID EVT_TIMEOUT = 7;
+    queueTestClockMs = 5000;
+    sm->setTimerClock(queueTestClock);
+    sm->addTransition(stateTransition(0, 0, 1, 1, 0, nullptr));
+    sm->addTransition(stateTransition(1, 0, 1, 1, 1, nullptr));
+    sm->addTransition(stateTransition(1, DONT_CARE_BUTTON, 2, 2, 0, nullptr));
+    sm->addTransition(stateTransition(1, DONT_CARE_BUTTON, EVT_TIMEOUT, 0, 0, nullptr));
+    TEST_ASSERT_TRUE_DEBUG(sm->addPageTimeout(1, 30000, EVT_TIMEOUT));
+    TEST_ASSERT_FALSE_DEBUG(sm->addPageTimeout(DONT_CARE_PAGE, 30000, EVT_TIMEOUT));
+    sm->initializeState(0, 0);
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(0, sm->getActiveTimerCount());
+
+    // Entering page 1 arms the timeout; activity on the page restarts it
+    sm->processEvent(1);
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(1, sm->getActiveTimerCount());
+    queueTestClockMs = 25000;
+    sm->processEvent(1);
+    queueTestClockMs = 35000;
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(0, sm->updateTimers());
+    queueTestClockMs = 54990;
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(0, sm->updateTimers());
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(1, sm->getCurrentPage());
+    queueTestClockMs = 55000;
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(REDRAW_MASK_PAGE | REDRAW_MASK_BUTTON | REDRAW_MASK_FULL, sm->updateTimers());
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(0, sm->getCurrentPage());
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(0, sm->getActiveTimerCount());
+
+    // Leaving the page cancels it
+    sm->processEvent(1);
+    sm->processEvent(2);
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(2, sm->getCurrentPage());
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(0, sm->getActiveTimerCount());
+    queueTestClockMs = 200000;
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(0, sm->updateTimers());
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(2, sm->getCurrentPage());
+
+    // Direct state changes arm it too
+    sm->setState(1, 0);
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(1, sm->getActiveTimerCount());
+    ENHANCED_UNITY_END_TEST_METHOD();
+}
+
+void test_314_scheduled_events() {
+    ENHANCED_UNITY_START_TEST_METHOD("test_314_scheduled_events", "test_queue.hpp", __LINE__);
+    uint32_t repeats = 0;
+    uint32_t* repeatsPtr = &repeats;
+    void* lastContext = nullptr;
+    void** lastContextPtr = &lastContext;
+    queueTestClockMs = 1000;
+    sm->setTimerClock(queueTestClock);
+    sm->addTransition(stateTransition(DONT_CARE_PAGE, DONT_CARE_BUTTON, 3, 3, 0,
+        [lastContextPtr](pageID, eventID, void* context) { *lastContextPtr = context; }));
+    sm->addTransition(stateTransition(DONT_CARE_PAGE, DONT_CARE_BUTTON, 4, 4, 0,
+        [repeatsPtr](pageID, eventID, void*) { (*repeatsPtr)++; }));
+    sm->addTransition(stateTransition(DONT_CARE_PAGE, DONT_CARE_BUTTON, 5, 5, 0, nullptr));
+    sm->initializeState(0, 0);
+
+    int marker = 0;
+    int32_t once = sm->scheduleEvent(700, 3, &marker);
+    int32_t repeat = sm->scheduleEvent(50, 4, nullptr, 50);
+    int32_t cancelled = sm->scheduleEvent(100, 5);
+    TEST_ASSERT_TRUE_DEBUG(once >= 0 && repeat >= 0 && cancelled >= 0);
+    TEST_ASSERT_TRUE_DEBUG(sm->cancelEvent(cancelled));
+    TEST_ASSERT_FALSE_DEBUG(sm->cancelEvent(cancelled));
+
+    queueTestClockMs = 1040;
+    sm->updateTimers();
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(0, repeats);
+    queueTestClockMs = 1050;
+    sm->updateTimers();
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(1, repeats);
+    // A long stall fires the periodic timer once, not once per missed period
+    queueTestClockMs = 1699;
+    sm->updateTimers();
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(2, repeats);
+    TEST_ASSERT_TRUE_DEBUG(lastContext == nullptr);
+    queueTestClockMs = 1700;
+    sm->updateTimers();
+    TEST_ASSERT_TRUE_DEBUG(lastContext == &marker);
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(3, sm->getCurrentPage());
+    TEST_ASSERT_FALSE_DEBUG(sm->cancelEvent(once));
+    TEST_ASSERT_TRUE_DEBUG(sm->cancelEvent(repeat));
+
+    // Beyond the wheel's span (about 2.9 hours at 10 ms ticks)
+    const uint32_t fourHours = 4UL * 3600UL * 1000UL;
+    sm->scheduleEvent(fourHours, 5);
+    queueTestClockMs = 1700 + fourHours - STATEMACHINE_TIMER_TICK_MS;
+    sm->updateTimers();
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(3, sm->getCurrentPage());
+    queueTestClockMs = 1700 + fourHours;
+    sm->updateTimers();
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(5, sm->getCurrentPage());
+
+    // Fixed pool
+    for (int i = 0; i < STATEMACHINE_MAX_TIMERS; i++) {
+        TEST_ASSERT_TRUE_DEBUG(sm->scheduleEvent(1000 + i, 5) >= 0);
+    }
+    TEST_ASSERT_EQUAL_INT_DEBUG(-1, sm->scheduleEvent(1000, 5));
+    ENHANCED_UNITY_END_TEST_METHOD();
+}
+
+void test_315_priority_events_preempt_backlog() {
+    ENHANCED_UNITY_START_TEST_METHOD("test_315_priority_events_preempt_backlog", "test_queue.hpp", __LINE__);
+    const eventID EVT_FAULT = 9;
+    const pageID PAGE_ERROR = 9;
+    sm->addTransition(stateTransition(DONT_CARE_PAGE, DONT_CARE_BUTTON, 1, 1, 0, nullptr));
+    sm->addTransition(stateTransition(DONT_CARE_PAGE, DONT_CARE_BUTTON, EVT_FAULT, PAGE_ERROR, 0, nullptr));
+    sm->initializeState(0, 0);
+
+    for (int i = 0; i < 5; i++) {
+        TEST_ASSERT_TRUE_DEBUG(sm->postEvent(1));
+    }
+    TEST_ASSERT_TRUE_DEBUG(sm->postEvent(EVT_FAULT, nullptr, eventPriority::HIGH));
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(5, sm->getQueuedEventCount(eventPriority::NORMAL));
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(1, sm->getQueuedEventCount(eventPriority::HIGH));
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(6, sm->getQueuedEventCount());
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+
+    // The fault goes first even though it was posted last
+    sm->drainEvents(1);
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(PAGE_ERROR, sm->getCurrentPage());
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(0, sm->getQueuedEventCount(eventPriority::HIGH));
+    TEST_ASSERT_TRUE_DEBUG(sm->getPriorityLatencyMax() >= 2000);
+
+    for (int i = 0; i < STATEMACHINE_PRIORITY_QUEUE_SIZE; i++) {
+        TEST_ASSERT_TRUE_DEBUG(sm->postEvent(EVT_FAULT, nullptr, eventPriority::HIGH));
+    }
+    TEST_ASSERT_FALSE_DEBUG(sm->postEvent(EVT_FAULT, nullptr, eventPriority::HIGH));
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(1, sm->getQueueOverflowCount(eventPriority::HIGH));
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(0, sm->getQueueOverflowCount(eventPriority::NORMAL));
+    sm->drainEvents();
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(0, sm->getQueuedEventCount());
+    sm->resetPriorityLatency();
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(0, sm->getPriorityLatencyMax());
+    ENHANCED_UNITY_END_TEST_METHOD();
+}
+
+void test_316_priority_global_dispatch() {
+    ENHANCED_UNITY_START_TEST_METHOD("test_316_priority_global_dispatch", "test_queue.hpp", __LINE__);
+    const eventID EVT_HOME = 6;
+    // Overlapping rows need validation off; the page row comes first and normally wins
+    sm->enableValidation(false);
+    sm->addTransition(stateTransition(1, 0, EVT_HOME, 2, 0, nullptr));
+    sm->addTransition(stateTransition(DONT_CARE_PAGE, 0, EVT_HOME, 0, 0, nullptr));
+    sm->initializeState(1, 0);
+
+    sm->postEvent(EVT_HOME, nullptr, eventPriority::HIGH);
+    sm->drainEvents();
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(2, sm->getCurrentPage());
+
+    sm->enablePriorityGlobalDispatch();
+    TEST_ASSERT_TRUE_DEBUG(sm->isPriorityGlobalDispatchEnabled());
+    sm->setState(1, 0);
+    sm->postEvent(EVT_HOME, nullptr, eventPriority::HIGH);
+    sm->drainEvents();
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(0, sm->getCurrentPage());
+
+    // NORMAL events keep first-match order
+    sm->setState(1, 0);
+    sm->postEvent(EVT_HOME);
+    sm->drainEvents();
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(2, sm->getCurrentPage());
+    ENHANCED_UNITY_END_TEST_METHOD();
+}
+
+#ifdef STATEMACHINE_HAS_COROUTINES
+// Minimal fire-and-forget coroutine for the awaitable tests
+struct queueTestTask {
+    struct promise_type {
+        queueTestTask get_return_object() { return queueTestTask(); }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_never final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() {}
+    };
+};
+
+struct queueAwaitProgress {
+    int step;
+    committedTransition first;
+    committedTransition last;
+};
+
+static queueTestTask queueAwaitScript(stateMachineWaiters<improvedStateMachine>& waiters, queueAwaitProgress& progress) {
+    progress.first = co_await waiters.nextTransition();
+    progress.step = 1;
+    co_await waiters.untilPage(3);
+    progress.step = 2;
+    co_await waiters.untilPage(3);   // Already there: no suspension
+    progress.step = 3;
+    progress.last = co_await waiters.untilTransition(3, 2, 0);
+    progress.step = 4;
+}
+
+void test_317_awaitable_state_waits() {
+    ENHANCED_UNITY_START_TEST_METHOD("test_317_awaitable_state_waits", "test_queue.hpp", __LINE__);
+    sm->addTransition(stateTransition(DONT_CARE_PAGE, DONT_CARE_BUTTON, 1, 1, 0, nullptr));
+    sm->addTransition(stateTransition(1, DONT_CARE_BUTTON, 3, 3, 0, nullptr));
+    sm->addTransition(stateTransition(3, DONT_CARE_BUTTON, 1, 0, 0, nullptr));
+    sm->addTransition(stateTransition(3, DONT_CARE_BUTTON, 2, 0, 0, nullptr));
+    sm->initializeState(0, 0);
+    {
+        stateMachineWaiters<improvedStateMachine> waiters(*sm);
+        queueAwaitProgress progress = {};
+        queueAwaitScript(waiters, progress);
+        TEST_ASSERT_EQUAL_INT_DEBUG(0, progress.step);
+        TEST_ASSERT_EQUAL_UINT32_DEBUG(1, waiters.waitingCount());
+
+        sm->processEvent(1);
+        TEST_ASSERT_EQUAL_INT_DEBUG(1, progress.step);
+        TEST_ASSERT_EQUAL_UINT8_DEBUG(0, progress.first.from.page);
+        TEST_ASSERT_EQUAL_UINT8_DEBUG(1, progress.first.to.page);
+        TEST_ASSERT_EQUAL_UINT8_DEBUG(1, progress.first.event);
+
+        sm->processEvent(3);
+        TEST_ASSERT_EQUAL_INT_DEBUG(3, progress.step);
+        // Same destination, wrong event
+        sm->processEvent(1);
+        TEST_ASSERT_EQUAL_INT_DEBUG(3, progress.step);
+        sm->processEvent(1);
+        sm->processEvent(3);
+        sm->processEvent(2);
+        TEST_ASSERT_EQUAL_INT_DEBUG(4, progress.step);
+        TEST_ASSERT_EQUAL_UINT8_DEBUG(2, progress.last.event);
+        TEST_ASSERT_EQUAL_UINT32_DEBUG(0, waiters.waitingCount());
+    }
+    ENHANCED_UNITY_END_TEST_METHOD();
+}
+#endif
+
+#if QUEUE_TEST_HOST_THREADS
+void test_318_snapshot_never_torn() {
+    ENHANCED_UNITY_START_TEST_METHOD("test_318_snapshot_never_torn", "test_queue.hpp", __LINE__);
+    // Page p / button p steps to (p + 1) % 5 on event 1, so every consistent
+    // snapshot has button == page and last one step behind
+    const uint8_t pages = 5;
+    for (uint8_t p = 0; p < pages; p++) {
+        sm->addTransition(stateTransition(p, p, 1, (p + 1) % pages, (p + 1) % pages, nullptr));
+    }
+    sm->initializeState(0, 0);
+    sm->processEvent(1);
+
+    std::atomic<bool> done(false);
+    std::atomic<uint32_t> torn(0);
+    std::atomic<uint32_t> reads(0);
+    std::thread reader([&done, &torn, &reads]() {
+        uint32_t lastSequence = 0;
+        while (!done.load(std::memory_order_acquire)) {
+            stateSnapshot snapshot = sm->getSnapshot();
+            bool consistent = snapshot.current.button == snapshot.current.page &&
+                              snapshot.last.button == snapshot.last.page &&
+                              (snapshot.last.page + 1) % pages == snapshot.current.page &&
+                              snapshot.redrawMask == (REDRAW_MASK_PAGE | REDRAW_MASK_BUTTON | REDRAW_MASK_FULL) &&
+                              snapshot.sequence >= lastSequence;
+            if (!consistent) torn.fetch_add(1, std::memory_order_relaxed);
+            lastSequence = snapshot.sequence;
+            reads.fetch_add(1, std::memory_order_relaxed);
+        }
+    });
+
+    for (uint32_t i = 0; i < QUEUE_TEST_THREAD_EVENTS; i++) {
+        sm->processEvent(1);
+    }
+    while (reads.load(std::memory_order_relaxed) == 0) {
+        std::this_thread::yield();
+    }
+    done.store(true, std::memory_order_release);
+    reader.join();
+
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(0, torn.load());
+    stateMachineStats stats = sm->getStatistics();
+    stateSnapshot final = sm->getSnapshot();
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(sm->getCurrentPage(), final.current.page);
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(sm->getLastPage(), final.last.page);
+    // initializeState plus one publish per transition
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(stats.stateChanges + 1, final.sequence);
+    ENHANCED_UNITY_END_TEST_METHOD();
+}
+
+// Eight pages of four buttons: 1 = next page, 2 = previous page, 3 = next button, 4 = home
+static void queueFleetMenu(improvedStateMachine* machine) {
+    const uint8_t pages = 8;
+    for (uint8_t p = 0; p < pages; p++) {
+        machine->addTransition(stateTransition(p, DONT_CARE_BUTTON, 1, (p + 1) % pages, 0, nullptr));
+        machine->addTransition(stateTransition(p, DONT_CARE_BUTTON, 2, (p + pages - 1) % pages, 0, nullptr));
+        for (uint8_t b = 0; b < 4; b++) {
+            machine->addTransition(stateTransition(p, b, 3, p, (b + 1) % 4, nullptr));
+        }
+    }
+    machine->addTransition(stateTransition(DONT_CARE_PAGE, DONT_CARE_BUTTON, 4, 0, 0, nullptr));
+}
+
+// Skewed lengths (every 16th unit replays 8x more) so the initial split is unbalanced
+static void queueFleetStreams(std::vector<std::vector<eventID> >& recorded, std::vector<fleetStream>& streams,
+                              size_t units) {
+    uint32_t seed = 12345;
+    recorded.assign(units, std::vector<eventID>());
+    streams.assign(units, fleetStream());
+    for (size_t u = 0; u < units; u++) {
+        const size_t length = (u % 16 == 0) ? QUEUE_TEST_FLEET_EVENTS * 8 : QUEUE_TEST_FLEET_EVENTS;
+        recorded[u].resize(length);
+        for (size_t e = 0; e < length; e++) {
+            seed = seed * 1103515245u + 12345u;
+            // Mostly navigation, occasionally an unhandled event 5
+            recorded[u][e] = static_cast<eventID>(1 + (seed >> 16) % 5);
+        }
+        streams[u] = fleetStream(recorded[u].data(), recorded[u].size());
+    }
+}
+
+void test_319_fleet_matches_sequential_replay() {
+    ENHANCED_UNITY_START_TEST_METHOD("test_319_fleet_matches_sequential_replay", "test_queue.hpp", __LINE__);
+    queueFleetMenu(sm);
+    stateMachineDefinition<>::pointer definition = stateMachineDefinition<>::create(*sm);
+    TEST_ASSERT_TRUE_DEBUG(definition != nullptr);
+    std::vector<std::vector<eventID> > recorded;
+    std::vector<fleetStream> streams;
+    queueFleetStreams(recorded, streams, QUEUE_TEST_FLEET_UNITS);
+
+    std::vector<stateMachineSession<> > reference(QUEUE_TEST_FLEET_UNITS, stateMachineSession<>(definition));
+    std::vector<stateMachineSession<> > fleet(QUEUE_TEST_FLEET_UNITS, stateMachineSession<>(definition));
+    uint64_t expectedEvents = 0;
+    for (size_t u = 0; u < reference.size(); u++) {
+        for (size_t e = 0; e < streams[u].count; e++) reference[u].processEvent(streams[u].events[e]);
+        expectedEvents += streams[u].count;
+    }
+
+    fleetSimulator simulator(4);
+    fleetResult result = simulator.run(fleet.data(), streams.data(), streams.size());
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(4, result.workers.size());
+    TEST_ASSERT_TRUE_DEBUG(result.totalEvents == expectedEvents);
+    uint32_t units = 0;
+    uint32_t stateChanges = 0;
+    uint32_t mismatches = 0;
+    for (size_t w = 0; w < result.workers.size(); w++) units += result.workers[w].units;
+    for (size_t u = 0; u < fleet.size(); u++) {
+        if (fleet[u].getCurrentPage() != reference[u].getCurrentPage() ||
+            fleet[u].getCurrentButton() != reference[u].getCurrentButton() ||
+            fleet[u].getStatistics().failedTransitions != reference[u].getStatistics().failedTransitions) {
+            mismatches++;
+        }
+        stateChanges += reference[u].getStatistics().stateChanges;
+    }
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(0, mismatches);
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(QUEUE_TEST_FLEET_UNITS, units);
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(stateChanges, result.stats.stateChanges);
+    TEST_ASSERT_TRUE_DEBUG(result.stats.totalTransitions == expectedEvents);
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(0xFF, result.scoreboard[0]);
+
+    // Full machines work as units too
+    std::vector<improvedStateMachine>* machines =
+        new std::vector<improvedStateMachine>(QUEUE_TEST_FLEET_MACHINES, *sm);
+    result = simulator.run(machines->data(), streams.data(), QUEUE_TEST_FLEET_MACHINES);
+    for (size_t u = 0; u < QUEUE_TEST_FLEET_MACHINES; u++) {
+        TEST_ASSERT_EQUAL_UINT8_DEBUG(reference[u].getCurrentPage(), (*machines)[u].getCurrentPage());
+        TEST_ASSERT_EQUAL_UINT8_DEBUG(reference[u].getCurrentButton(), (*machines)[u].getCurrentButton());
+    }
+    delete machines;
+    ENHANCED_UNITY_END_TEST_METHOD();
+}
+
+void test_320_fleet_throughput_per_core() {
+    ENHANCED_UNITY_START_TEST_METHOD("test_320_fleet_throughput_per_core", "test_queue.hpp", __LINE__);
+    queueFleetMenu(sm);
+    stateMachineDefinition<>::pointer definition = stateMachineDefinition<>::create(*sm);
+    std::vector<std::vector<eventID> > recorded;
+    std::vector<fleetStream> streams;
+    queueFleetStreams(recorded, streams, QUEUE_TEST_FLEET_UNITS);
+
+    uint64_t expectedEvents = 0;
+    for (size_t u = 0; u < streams.size(); u++) expectedEvents += streams[u].count;
+
+    // Every worker count must replay the same fleet to the same totals
+    const unsigned cores = fleetSimulator().getWorkerCount();
+    uint32_t firstStateChanges = 0;
+    for (unsigned workers = 1;; workers = std::min(workers * 2, cores)) {
+        std::vector<stateMachineSession<> > fleet(QUEUE_TEST_FLEET_UNITS, stateMachineSession<>(definition));
+        fleetResult result = fleetSimulator(workers).run(fleet.data(), streams.data(), streams.size());
+        uint32_t steals = 0;
+        uint32_t units = 0;
+        for (size_t w = 0; w < result.workers.size(); w++) {
+            steals += result.workers[w].steals;
+            units += result.workers[w].units;
+        }
+        if (workers == 1) firstStateChanges = result.stats.stateChanges;
+        TEST_ASSERT_EQUAL_UINT32_DEBUG(workers, result.workers.size());
+        TEST_ASSERT_EQUAL_UINT32_DEBUG(QUEUE_TEST_FLEET_UNITS, units);
+        TEST_ASSERT_TRUE_DEBUG(result.totalEvents == expectedEvents);
+        TEST_ASSERT_TRUE_DEBUG(result.stats.totalTransitions == expectedEvents);
+        TEST_ASSERT_EQUAL_UINT32_DEBUG(firstStateChanges, result.stats.stateChanges);
+        printf("Fleet %u worker(s): %.0f events/s, %.0f events/s per worker, %u steals\n", workers,
+               result.eventsPerSecond(), result.eventsPerSecondPerWorker(), steals);
+        if (workers == cores) break;
+    }
+    ENHANCED_UNITY_END_TEST_METHOD();
+}
+
+#endif
+
+// Every page 0..7 steps to (p + 1) % 4 + offset on event 1, so any complete table handles
+// every reachable state
+static std::shared_ptr<improvedStateMachine> queueLiveTable(uint8_t offset) {
+    std::shared_ptr<improvedStateMachine> table = std::make_shared<improvedStateMachine>();
+    for (uint8_t p = 0; p < 8; p++) {
+        table->addTransition(stateTransition(p, 0, 1, (p + 1) % 4 + offset, 0, nullptr));
+    }
+    table->seal();
+    return table;
+}
+
+void test_321_live_table_swap_between_events() {
+    ENHANCED_UNITY_START_TEST_METHOD("test_321_live_table_swap_between_events", "test_queue.hpp", __LINE__);
+    sm->addTransition(stateTransition(0, 0, 1, 7, 0, nullptr));
+    sm->initializeState(0, 0);
+    rcuPointer<improvedStateMachine> live;
+    TEST_ASSERT_TRUE_DEBUG(sm->attachLiveTable(&live));
+    TEST_ASSERT_TRUE_DEBUG(sm->isLiveTableAttached());
+
+    // Nothing published yet: the machine's own rows still apply
+    sm->processEvent(1);
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(7, sm->getCurrentPage());
+
+    std::shared_ptr<improvedStateMachine> first = queueLiveTable(0);
+    std::weak_ptr<improvedStateMachine> firstWatch = first;
+    live.publish(first);
+    first.reset();
+    sm->processEvent(1);
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(0, sm->getCurrentPage());
+
+    live.publish(queueLiveTable(4));
+    // No reader was inside, so the old version is released at once
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(0, live.getRetiredCount());
+    TEST_ASSERT_TRUE_DEBUG(firstWatch.expired());
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(2, live.getVersion());
+    sm->processEvent(1);
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(5, sm->getCurrentPage());
+    // Batches and coalesced runs go through the live table as well
+    const eventID burst[] = { 1, 1 };
+    sm->processEventsCoalesced(burst, 2, QUEUE_TEST_NAV_EVENTS);
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(7, sm->getCurrentPage());
+
+    TEST_ASSERT_TRUE_DEBUG(sm->attachLiveTable(nullptr));
+    TEST_ASSERT_FALSE_DEBUG(sm->isLiveTableAttached());
+    sm->forceState(0, 0);
+    sm->processEvent(1);
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(7, sm->getCurrentPage());
+
+    // Reader slots are limited
+    for (int i = 0; i < STATEMACHINE_RCU_MAX_READERS; i++) {
+        TEST_ASSERT_TRUE_DEBUG(live.registerReader() >= 0);
+    }
+    TEST_ASSERT_FALSE_DEBUG(sm->attachLiveTable(&live));
+    ENHANCED_UNITY_END_TEST_METHOD();
+}
+
+void test_322_publish_inside_action_waits_for_grace_period() {
+    ENHANCED_UNITY_START_TEST_METHOD("test_322_publish_inside_action_waits_for_grace_period", "test_queue.hpp", __LINE__);
+    rcuPointer<improvedStateMachine> live;
+    rcuPointer<improvedStateMachine>* livePtr = &live;
+    size_t retiredInAction = 0;
+    size_t* retiredPtr = &retiredInAction;
+    std::shared_ptr<improvedStateMachine> first = std::make_shared<improvedStateMachine>();
+    first->addTransition(stateTransition(0, 0, 1, 2, 0,
+        [livePtr, retiredPtr](pageID, eventID, void*) {
+            livePtr->publish(queueLiveTable(4));
+            *retiredPtr = livePtr->getRetiredCount();
+        }));
+    first->seal();
+    std::weak_ptr<improvedStateMachine> firstWatch = first;
+    live.publish(first);
+    first.reset();
+
+    sm->initializeState(0, 0);
+    TEST_ASSERT_TRUE_DEBUG(sm->attachLiveTable(&live));
+    sm->processEvent(1);
+    // The running transition pinned the old table and committed its target
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(1, retiredInAction);
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(2, sm->getCurrentPage());
+    TEST_ASSERT_FALSE_DEBUG(firstWatch.expired());
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(0, live.reclaim());
+    TEST_ASSERT_TRUE_DEBUG(firstWatch.expired());
+    sm->processEvent(1);
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(7, sm->getCurrentPage());
+    sm->attachLiveTable(nullptr);
+    ENHANCED_UNITY_END_TEST_METHOD();
+}
+
+#if QUEUE_TEST_HOST_THREADS
+void test_323_hot_swap_under_load() {
+    ENHANCED_UNITY_START_TEST_METHOD("test_323_hot_swap_under_load", "test_queue.hpp", __LINE__);
+    rcuPointer<improvedStateMachine> live;
+    live.publish(queueLiveTable(0));
+    sm->initializeState(0, 0);
+    TEST_ASSERT_TRUE_DEBUG(sm->attachLiveTable(&live));
+
+    std::atomic<bool> done(false);
+    std::thread writer([&live, &done]() {
+        for (uint32_t i = 1; i <= QUEUE_TEST_LIVE_PUBLISHES; i++) {
+            live.publish(queueLiveTable((i % 2) * 4));
+            std::this_thread::yield();
+        }
+        done.store(true, std::memory_order_release);
+    });
+
+    uint32_t events = 0;
+    while (!done.load(std::memory_order_acquire) || events < QUEUE_TEST_THREAD_EVENTS / 10) {
+        sm->processEvent(1);
+        events++;
+    }
+    writer.join();
+    live.synchronize();
+
+    // A torn or half-built table would leave some state unhandled
+    stateMachineStats stats = sm->getStatistics();
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(0, stats.failedTransitions);
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(events, stats.stateChanges);
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(QUEUE_TEST_LIVE_PUBLISHES + 1, live.getVersion());
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(0, live.getRetiredCount());
+    sm->attachLiveTable(nullptr);
+    ENHANCED_UNITY_END_TEST_METHOD();
+}
+
+void test_324_sharded_statistics_aggregate() {
+    ENHANCED_UNITY_START_TEST_METHOD("test_324_sharded_statistics_aggregate", "test_queue.hpp", __LINE__);
+    queueFleetMenu(sm);
+    stateMachineDefinition<>::pointer definition = stateMachineDefinition<>::create(*sm);
+    shardedStatistics<> totals;
+
+    // Every thread runs its own session; event 5 is unhandled
+    std::thread threads[QUEUE_TEST_STATS_THREADS];
+    for (size_t t = 0; t < QUEUE_TEST_STATS_THREADS; t++) {
+        threads[t] = std::thread([definition, &totals]() {
+            stateMachineSession<improvedStateMachine, shardedStatistics<> > session(definition, &totals);
+            for (uint32_t i = 0; i < QUEUE_TEST_STATS_EVENTS; i++) {
+                session.processEvent((i % 4 == 3) ? 5 : 1);
+            }
+        });
+    }
+    for (size_t t = 0; t < QUEUE_TEST_STATS_THREADS; t++) threads[t].join();
+
+    const uint32_t events = QUEUE_TEST_STATS_THREADS * (QUEUE_TEST_STATS_EVENTS);
+    stateMachineStats stats = totals.getStatistics();
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(events, stats.totalTransitions);
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(events / 4, stats.failedTransitions);
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(events - events / 4, stats.stateChanges);
+
+    // Machine statistics fold in as blocks
+    sm->initializeState(0, 0);
+    sm->resetStatistics();
+    sm->processEvent(1);
+    sm->processEvent(5);
+    totals.reset();
+    totals.add(sm->getStatistics());
+    stats = totals.getStatistics();
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(2, stats.totalTransitions);
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(1, stats.stateChanges);
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(sm->getStatistics().maxTransitionTime, stats.maxTransitionTime);
+    ENHANCED_UNITY_END_TEST_METHOD();
+}
+
+// Runs QUEUE_TEST_STATS_THREADS sessions in parallel and returns events per millisecond
+template <typename Statistics>
+static unsigned long queueStatisticsThroughput(stateMachineDefinition<>::pointer definition, Statistics* totals) {
+    std::atomic<bool> go(false);
+    std::thread threads[QUEUE_TEST_STATS_THREADS];
+    for (size_t t = 0; t < QUEUE_TEST_STATS_THREADS; t++) {
+        threads[t] = std::thread([definition, totals, &go]() {
+            stateMachineSession<improvedStateMachine, Statistics> session(definition, totals);
+            while (!go.load(std::memory_order_acquire)) std::this_thread::yield();
+            for (uint32_t i = 0; i < QUEUE_TEST_STATS_BENCH_EVENTS; i++) {
+                session.processEvent(1);
+            }
+        });
+    }
+    unsigned long start = micros();
+    go.store(true, std::memory_order_release);
+    for (size_t t = 0; t < QUEUE_TEST_STATS_THREADS; t++) threads[t].join();
+    unsigned long elapsed = micros() - start;
+    return elapsed ? static_cast<unsigned long>(
+        static_cast<uint64_t>(QUEUE_TEST_STATS_THREADS) * QUEUE_TEST_STATS_BENCH_EVENTS * 1000ULL / elapsed) : 0;
+}
+
+void test_326_sharded_statistics_contention() {
+    ENHANCED_UNITY_START_TEST_METHOD("test_326_sharded_statistics_contention", "test_queue.hpp", __LINE__);
+    queueFleetMenu(sm);
+    stateMachineDefinition<>::pointer definition = stateMachineDefinition<>::create(*sm);
+    // One shard is the single shared counter block every thread bounces
+    shardedStatistics<1>* shared = new shardedStatistics<1>();
+    shardedStatistics<QUEUE_TEST_STATS_THREADS>* sharded = new shardedStatistics<QUEUE_TEST_STATS_THREADS>();
+
+    unsigned long none = queueStatisticsThroughput<noSharedStatistics>(definition, nullptr);
+    unsigned long single = queueStatisticsThroughput(definition, shared);
+    unsigned long perThread = queueStatisticsThroughput(definition, sharded);
+    printf("Statistics on %u threads (%u cores): none %lu, shared %lu, sharded %lu events/ms\n",
+           static_cast<unsigned>(QUEUE_TEST_STATS_THREADS), std::thread::hardware_concurrency(), none, single,
+           perThread);
+
+    const uint32_t events = QUEUE_TEST_STATS_THREADS * QUEUE_TEST_STATS_BENCH_EVENTS;
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(events, shared->getStatistics().stateChanges);
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(events, sharded->getStatistics().stateChanges);
+    delete shared;
+    delete sharded;
+    ENHANCED_UNITY_END_TEST_METHOD();
+}
+
+#endif
+
+void test_325_timer_wheel_jumps_idle_ticks() {
+    ENHANCED_UNITY_START_TEST_METHOD("test_325_timer_wheel_jumps_idle_ticks", "test_queue.hpp", __LINE__);
+    // Ascending delays around slot, wrap and level boundaries, plus one beyond the wheel
+    const uint32_t delays[] = { 1, 2, 31, 32, 33, 63, 64, 1000, 1024, 1025, 32768, 40000, (1UL << 20) + 5 };
+    const size_t count = sizeof(delays) / sizeof(delays[0]);
+    const uint32_t start = 7;
+    timerWheel<16> wheel;
+    wheel.advanceTo(start);
+    for (size_t i = 0; i < count; i++) {
+        TEST_ASSERT_TRUE_DEBUG(wheel.schedule(delays[i], static_cast<uint8_t>(i), nullptr) >= 0);
+    }
+
+    // Each timer fires exactly at its tick even when the clock jumps straight there
+    for (size_t i = 0; i < count; i++) {
+        wheel.advanceTo(start + delays[i] - 1);
+        TEST_ASSERT_FALSE_DEBUG(wheel.hasExpired());
+        wheel.advanceTo(start + delays[i]);
+        expiredTimer timer;
+        TEST_ASSERT_TRUE_DEBUG(wheel.popExpired(timer));
+        TEST_ASSERT_EQUAL_UINT8_DEBUG(i, timer.event);
+        TEST_ASSERT_FALSE_DEBUG(wheel.popExpired(timer));
+    }
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(0, wheel.activeCount());
+
+    // An idle wheel still follows the clock
+    wheel.advanceTo(start + (1UL << 22));
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(start + (1UL << 22), wheel.now());
+    ENHANCED_UNITY_END_TEST_METHOD();
+}
+
+void test_327_coalescing_folds_only_navigation_events() {
+    ENHANCED_UNITY_START_TEST_METHOD("test_327_coalescing_folds_only_navigation_events", "test_queue.hpp", __LINE__);
+    std::array<pageID, STATEMACHINE_MAX_MENU_LABELS> targets = {};
+    targets[2] = 2;
+    sm->addButtonNavigation(1, 4, targets);   // DOWN = 0 from button 2 opens page 2
+    sm->initializeState(1, 0);
+
+    // DOWN is action-free but not navigation: the RIGHT run commits first, DOWN on its own
+    const eventID events[] = {1, 1, 0};
+    sm->processEventsCoalesced(events, 3, QUEUE_TEST_NAV_EVENTS);
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(2, sm->getCurrentPage());
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(1, sm->getLastPage());
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(2, sm->getLastButton());
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(3, sm->getStatistics().stateChanges);
+    ENHANCED_UNITY_END_TEST_METHOD();
+}
+
+void test_328_coalescing_stops_at_page_timeouts() {
+    ENHANCED_UNITY_START_TEST_METHOD("test_328_coalescing_stops_at_page_timeouts", "test_queue.hpp", __LINE__);
+    const eventID EVT_DOWN = 0, EVT_BACK = 3, EVT_TIMEOUT = 7;
+    const uint32_t navigation = QUEUE_TEST_NAV_EVENTS | (1UL << EVT_DOWN) | (1UL << EVT_BACK);
+    queueTestClockMs = 1000;
+    sm->setTimerClock(queueTestClock);
+    std::array<pageID, STATEMACHINE_MAX_MENU_LABELS> targets = {};
+    targets[0] = 2;
+    sm->addButtonNavigation(1, 4, targets);
+    sm->addTransition(stateTransition(2, DONT_CARE_BUTTON, EVT_BACK, 1, 0, nullptr));
+    sm->addTransition(stateTransition(2, DONT_CARE_BUTTON, EVT_TIMEOUT, 1, 0, nullptr));
+    TEST_ASSERT_TRUE_DEBUG(sm->addPageTimeout(2, 500, EVT_TIMEOUT));
+    sm->initializeState(1, 0);
+
+    // Entering page 2 is committed on its own, so its timeout is armed and then cancelled
+    const eventID through[] = {EVT_DOWN, EVT_BACK};
+    sm->processEventsCoalesced(through, 2, navigation);
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(1, sm->getCurrentPage());
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(2, sm->getLastPage());
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(0, sm->getActiveTimerCount());
+
+    // A run that ends on page 2 leaves its timeout running
+    const eventID into[] = {1, 2, EVT_DOWN};
+    sm->processEventsCoalesced(into, 3, navigation);
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(2, sm->getCurrentPage());
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(1, sm->getActiveTimerCount());
+    queueTestClockMs = 1500;
+    sm->updateTimers();
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(1, sm->getCurrentPage());
+    ENHANCED_UNITY_END_TEST_METHOD();
+}
+
+#ifdef STATEMACHINE_HAS_COROUTINES
+static queueTestTask queueAwaitIntermediatePage(stateMachineWaiters<improvedStateMachine>& waiters, int& step) {
+    co_await waiters.untilPage(2);
+    step = 1;
+}
+
+void test_329_coalescing_wakes_waiters_on_passed_pages() {
+    ENHANCED_UNITY_START_TEST_METHOD("test_329_coalescing_wakes_waiters_on_passed_pages", "test_queue.hpp", __LINE__);
+    const eventID EVT_DOWN = 0, EVT_BACK = 3;
+    const uint32_t navigation = QUEUE_TEST_NAV_EVENTS | (1UL << EVT_DOWN) | (1UL << EVT_BACK);
+    std::array<pageID, STATEMACHINE_MAX_MENU_LABELS> targets = {};
+    targets[0] = 2;
+    sm->addButtonNavigation(1, 4, targets);
+    sm->addTransition(stateTransition(2, DONT_CARE_BUTTON, EVT_BACK, 1, 0, nullptr));
+    sm->initializeState(1, 0);
+    {
+        stateMachineWaiters<improvedStateMachine> waiters(*sm);
+        int step = 0;
+        queueAwaitIntermediatePage(waiters, step);
+        TEST_ASSERT_EQUAL_UINT32_DEBUG(1, waiters.waitingCount());
+
+        // Page 2 is only passed through, but the waiter sees it
+        const eventID through[] = {EVT_DOWN, EVT_BACK};
+        sm->processEventsCoalesced(through, 2, navigation);
+        TEST_ASSERT_EQUAL_INT_DEBUG(1, step);
+        TEST_ASSERT_EQUAL_UINT32_DEBUG(0, waiters.waitingCount());
+        TEST_ASSERT_EQUAL_UINT8_DEBUG(1, sm->getCurrentPage());
+
+        // With nobody waiting, runs fold again
+        const eventID spin[] = {1, 1};
+        sm->processEventsCoalesced(spin, 2, navigation);
+        TEST_ASSERT_EQUAL_UINT8_DEBUG(0, sm->getLastButton());
+        TEST_ASSERT_EQUAL_UINT8_DEBUG(2, sm->getCurrentButton());
+    }
+    ENHANCED_UNITY_END_TEST_METHOD();
+}
+#endif
+
+void test_330_coalescing_respects_recursion_limit() {
+    ENHANCED_UNITY_START_TEST_METHOD("test_330_coalescing_respects_recursion_limit", "test_queue.hpp", __LINE__);
+    uint32_t calls = 0;
+    uint32_t* callsPtr = &calls;
+    improvedStateMachine* machine = sm;
+    std::array<pageID, STATEMACHINE_MAX_MENU_LABELS> targets = {};
+    sm->addButtonNavigation(1, 4, targets);
+    // Each action runs a RIGHT and raises itself again through the coalescing front-end
+    sm->addTransition(stateTransition(1, DONT_CARE_BUTTON, 5, 1, 0,
+        [machine, callsPtr](pageID, eventID, void*) {
+            (*callsPtr)++;
+            const eventID nested[] = {1, 5};
+            machine->processEventsCoalesced(nested, 2, QUEUE_TEST_NAV_EVENTS);
+        }));
+    sm->initializeState(1, 0);
+
+    const eventID start[] = {5};
+    sm->processEventsCoalesced(start, 1, QUEUE_TEST_NAV_EVENTS);
+    // At the depth limit nothing is folded: both nested events are rejected
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(STATEMACHINE_MAX_RECURSION_DEPTH, calls);
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(2, sm->getStatistics().failedTransitions);
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(1, sm->getCurrentPage());
+    TEST_ASSERT_EQUAL_UINT8_DEBUG(0, sm->getCurrentButton());
+    ENHANCED_UNITY_END_TEST_METHOD();
+}
+
+#ifdef STATEMACHINE_HAS_COROUTINES
+// Coroutine whose frame outlives its body, so a test can destroy it
+struct queueOwnedTask {
+    struct promise_type {
+        queueOwnedTask get_return_object() {
+            return queueOwnedTask{std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+        std::suspend_never initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() {}
+    };
+    std::coroutine_handle<promise_type> handle;
+};
+
+static queueOwnedTask queueAwaitThenDestroy(stateMachineWaiters<improvedStateMachine>& waiters,
+                                            std::coroutine_handle<>& victim, int& step) {
+    co_await waiters.nextTransition();
+    victim.destroy();
+    step = 1;
+}
+
+static queueOwnedTask queueAwaitVictim(stateMachineWaiters<improvedStateMachine>& waiters, int& step) {
+    co_await waiters.nextTransition();
+    step = 1;
+}
+
+void test_331_resumed_waiter_destroys_ready_waiter() {
+    ENHANCED_UNITY_START_TEST_METHOD("test_331_resumed_waiter_destroys_ready_waiter", "test_queue.hpp", __LINE__);
+    sm->addTransition(stateTransition(0, DONT_CARE_BUTTON, 1, 1, 0, nullptr));
+    sm->initializeState(0, 0);
+    {
+        stateMachineWaiters<improvedStateMachine> waiters(*sm);
+        int killerStep = 0;
+        int victimStep = 0;
+        std::coroutine_handle<> victim;
+        queueOwnedTask killer = queueAwaitThenDestroy(waiters, victim, killerStep);
+        queueOwnedTask target = queueAwaitVictim(waiters, victimStep);
+        victim = target.handle;
+        TEST_ASSERT_EQUAL_UINT32_DEBUG(2, waiters.waitingCount());
+
+        // Both match the same commit; the first resumed destroys the second
+        sm->processEvent(1);
+        TEST_ASSERT_EQUAL_INT_DEBUG(1, killerStep);
+        TEST_ASSERT_EQUAL_INT_DEBUG(0, victimStep);
+        TEST_ASSERT_EQUAL_UINT32_DEBUG(0, waiters.waitingCount());
+        TEST_ASSERT_EQUAL_UINT8_DEBUG(1, sm->getCurrentPage());
+        killer.handle.destroy();
+    }
+    ENHANCED_UNITY_END_TEST_METHOD();
+}
+#endif
+
+// Expose registration function for shared runner
+void register_queue_tests() {
+    RUN_TEST_DEBUG(test_301_post_and_drain_in_order);
+    RUN_TEST_DEBUG(test_302_queue_overflow_is_counted);
+#if QUEUE_TEST_HOST_THREADS
+    RUN_TEST_DEBUG(test_303_threaded_producer_keeps_order);
+#endif
+    RUN_TEST_DEBUG(test_304_mpsc_round_robin_fairness);
+    RUN_TEST_DEBUG(test_305_mpsc_statistics);
+#if QUEUE_TEST_HOST_THREADS
+    RUN_TEST_DEBUG(test_306_mpsc_producer_scaling);
+#endif
+    RUN_TEST_DEBUG(test_307_batch_matches_single_events);
+    RUN_TEST_DEBUG(test_308_batch_actions_see_live_state);
+    RUN_TEST_DEBUG(test_309_run_to_completion_commits_before_chained_event);
+    RUN_TEST_DEBUG(test_310_run_to_completion_bounds_chains);
+    RUN_TEST_DEBUG(test_311_coalesced_navigation_burst);
+    RUN_TEST_DEBUG(test_312_coalescing_stops_at_actions);
+    RUN_TEST_DEBUG(test_313_page_idle_timeout);
+    RUN_TEST_DEBUG(test_314_scheduled_events);
+    RUN_TEST_DEBUG(test_315_priority_events_preempt_backlog);
+    RUN_TEST_DEBUG(test_316_priority_global_dispatch);
+#ifdef STATEMACHINE_HAS_COROUTINES
+    RUN_TEST_DEBUG(test_317_awaitable_state_waits);
+#endif
+#if QUEUE_TEST_HOST_THREADS
+    RUN_TEST_DEBUG(test_318_snapshot_never_torn);
+    RUN_TEST_DEBUG(test_319_fleet_matches_sequential_replay);
+    RUN_TEST_DEBUG(test_320_fleet_throughput_per_core);
+#endif
+    RUN_TEST_DEBUG(test_321_live_table_swap_between_events);
+    RUN_TEST_DEBUG(test_322_publish_inside_action_waits_for_grace_period);
+#if QUEUE_TEST_HOST_THREADS
+    RUN_TEST_DEBUG(test_323_hot_swap_under_load);
+    RUN_TEST_DEBUG(test_324_sharded_statistics_aggregate);
+#endif
+    RUN_TEST_DEBUG(test_325_timer_wheel_jumps_idle_ticks);
+#if QUEUE_TEST_HOST_THREADS
+    RUN_TEST_DEBUG(test_326_sharded_statistics_contention);
+#endif
+    RUN_TEST_DEBUG(test_327_coalescing_folds_only_navigation_events);
+    RUN_TEST_DEBUG(test_328_coalescing_stops_at_page_timeouts);
+#ifdef STATEMACHINE_HAS_COROUTINES
+    RUN_TEST_DEBUG(test_329_coalescing_wakes_waiters_on_passed_pages);
+#endif
+    RUN_TEST_DEBUG(test_330_coalescing_respects_recursion_limit);
+#ifdef STATEMACHINE_HAS_COROUTINES
+    RUN_TEST_DEBUG(test_331_resumed_waiter_destroys_ready_waiter);
+#endif
+}
+
+#endif // BUILDING_TEST_RUNNER_BUNDLE
@@ -270,10 +270,11 @@ void test_maximum_capacity_limits() {
     ENHANCED_UNITY_START_TEST_METHOD("test_maximum_capacity_limits", "test_safety.hpp", __LINE__);
 
     // Test maximum pages limit
-    for (int i = 0; i < STATEMACHINE_MAX_PAGES; i++) {
+    const int maxPages = static_cast<int>(sm->getMaxStates());
+    for (int i = 0; i < maxPages; i++) {
         stateDefinition state(i, "State", "Test State");
         validationResult result = sm->addState(state);
-        if (i < STATEMACHINE_MAX_PAGES - 1) {
+        if (i < maxPages - 1) {
             TEST_ASSERT_EQUAL_INT_DEBUG(static_cast<int>(validationResult::VALID), static_cast<int>(result));
         } else {
             // Last state should succeed
@@ -282,7 +283,7 @@ void test_maximum_capacity_limits() {
     }
     
     // Try to add one more state
-    stateDefinition extraState(STATEMACHINE_MAX_PAGES, "Extra", "Extra State");
+    stateDefinition extraState(maxPages, "Extra", "Extra State");
     validationResult result = sm->addState(extraState);
     TEST_ASSERT_EQUAL_INT_DEBUG(static_cast<int>(validationResult::MAX_PAGES_EXCEEDED), static_cast<int>(result));
     
@@ -432,8 +433,15 @@ void test_capacity_query_methods() {
     size_t maxTransitions = sm->getMaxTransitions();
     size_t maxStates = sm->getMaxStates();
     
+    // Without a heap page pool the machine holds only its inline pool
+#ifdef STATEMACHINE_PAGE_POOL_HEAP
+    const size_t expectedStates = STATEMACHINE_MAX_PAGES;
+#else
+    const size_t expectedStates = (STATEMACHINE_PAGE_POOL_SIZE < STATEMACHINE_MAX_PAGES) ? STATEMACHINE_PAGE_POOL_SIZE
+                                                                                        : STATEMACHINE_MAX_PAGES;
+#endif
     TEST_ASSERT_EQUAL_UINT32_DEBUG(STATEMACHINE_MAX_TRANSITIONS, maxTransitions);
-    TEST_ASSERT_EQUAL_UINT32_DEBUG(STATEMACHINE_MAX_PAGES, maxStates);
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(expectedStates, maxStates);
     
     // Test current counts
     size_t transitionCount = sm->getTransitionCount();
@@ -447,7 +455,7 @@ void test_capacity_query_methods() {
     size_t availableStates = sm->getAvailableStates();
     
     TEST_ASSERT_EQUAL_UINT32_DEBUG(STATEMACHINE_MAX_TRANSITIONS, availableTransitions);
-    TEST_ASSERT_EQUAL_UINT32_DEBUG(STATEMACHINE_MAX_PAGES, availableStates);
+    TEST_ASSERT_EQUAL_UINT32_DEBUG(expectedStates, availableStates);
     
     ENHANCED_UNITY_END_TEST_METHOD();
     sm->setDebugMode(false);